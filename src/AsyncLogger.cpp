@@ -0,0 +1,347 @@
+#include <iomanip>
+#include "AsyncLogger.h"
+
+static const char BINARY_MAGIC[4] = { 'O', 'F', 'L', 'B' };
+static const uint8_t BINARY_VERSION = 1;
+
+AsyncLogger* AsyncLogger::getInstance()
+{
+	// Built on first use, C++11 guarantees only one thread does it
+	static AsyncLogger logger;
+	return &logger;
+}
+
+AsyncLogger::AsyncLogger() : records(CAPACITY)
+{
+	this->droppedRecords = 0;
+	this->reportedDroppedRecords = 0;
+	this->lastRateLimitFlush = 0;
+	this->consoleEnabled = true;
+	this->textEnabled = false;
+	this->startThread();
+}
+
+AsyncLogger::~AsyncLogger()
+{
+	this->stop();
+}
+
+void AsyncLogger::setConsoleEnabled(bool consoleEnabled)
+{
+	this->consoleEnabled = consoleEnabled;
+}
+
+void AsyncLogger::setTextFile(const string& path)
+{
+	this->lock();
+	if (path != this->textPath) {
+		this->textPath = path;
+		if (this->textFile.is_open()) this->textFile.close();
+		if (path != "") this->textFile.open(ofToDataPath(path).c_str(), ios::out | ios::app);
+		this->textEnabled = this->textFile.is_open();
+	}
+	this->unlock();
+}
+
+void AsyncLogger::setBinaryFile(const string& path)
+{
+	this->lock();
+	if (path != this->binaryPath) {
+		this->binaryPath = path;
+		if (this->binaryFile.is_open()) this->binaryFile.close();
+		this->binaryFormats.clear();
+		if (path != "") {
+			this->binaryFile.open(ofToDataPath(path).c_str(), ios::out | ios::binary | ios::trunc);
+			this->binaryFile.write(BINARY_MAGIC, 4);
+			this->binaryFile.put(BINARY_VERSION);
+		}
+	}
+	this->unlock();
+}
+
+string AsyncLogger::getBinaryFile()
+{
+	this->lock();
+	string path = this->binaryPath;
+	this->unlock();
+	return path;
+}
+
+void AsyncLogger::stop()
+{
+	if (this->isThreadRunning()) this->waitForThread(true);
+	// The thread is gone, whatever it left is written from here
+	this->drain();
+	this->flushRateLimits(ofGetSystemTimeMillis(), true);
+	this->lock();
+	if (this->textFile.is_open()) this->textFile.close();
+	if (this->binaryFile.is_open()) this->binaryFile.close();
+	this->textPath = "";
+	this->binaryPath = "";
+	this->textEnabled = false;
+	this->unlock();
+}
+
+void AsyncLogger::addArgument(Record& record, const char* value)
+{
+	if (record.argumentCount == MAX_ARGUMENTS) return;
+	const int i = record.argumentCount++;
+	record.types[i] = TEXT;
+	// Whatever doesn't fit is cut, past the end of the buffer the argument is left out
+	const int space = STRING_BYTES - record.stringBytes - 1;
+	if (space < 0) {
+		record.argumentCount--;
+		return;
+	}
+	const int length = (value == NULL) ? 0 : min((int)strlen(value), space);
+	memcpy(record.strings + record.stringBytes, value, length);
+	record.strings[record.stringBytes + length] = 0;
+	record.stringBytes += length + 1;
+}
+
+void AsyncLogger::addArgument(Record& record, const string& value)
+{
+	AsyncLogger::addArgument(record, value.c_str());
+}
+
+void AsyncLogger::formatRecord(const Record& record, string& output)
+{
+	int argument = 0;
+	const char* strings = record.strings;
+	for (const char* p = record.format; *p != 0; p++) {
+		if (p[0] != '{' || p[1] != '}' || argument == record.argumentCount) {
+			output += *p;
+			continue;
+		}
+		char number[32];
+		switch (record.types[argument]) {
+		case INTEGER:
+			snprintf(number, sizeof(number), "%lld", (long long)record.integers[argument]);
+			output += number;
+			break;
+		case REAL:
+			snprintf(number, sizeof(number), "%g", record.reals[argument]);
+			output += number;
+			break;
+		case TEXT:
+			output += strings;
+			strings += strlen(strings) + 1;
+			break;
+		}
+		argument++;
+		p++;
+	}
+}
+
+// ------ Background thread ------
+
+void AsyncLogger::threadedFunction()
+{
+	while (this->isThreadRunning()) {
+		this->drain();
+		this->flushRateLimits(ofGetSystemTimeMillis(), false);
+		this->sleep(5);
+	}
+}
+
+void AsyncLogger::drain()
+{
+	Record* record;
+	while ((record = this->records.front()) != NULL) {
+		this->write(*record);
+		this->records.pop();
+	}
+
+	int dropped = this->droppedRecords;
+	if (dropped != this->reportedDroppedRecords) {
+		this->text = "AsyncLogger: " + ofToString(dropped - this->reportedDroppedRecords) + " messages dropped, the queue was full";
+		this->writeText(LOG_LEVEL_WARNING, ofGetSystemTimeMillis(), this->text);
+		this->reportedDroppedRecords = dropped;
+	}
+}
+
+void AsyncLogger::write(const Record& record)
+{
+	this->lock();
+	if (this->binaryFile.is_open()) this->writeBinary(record);
+	this->unlock();
+	if (!this->consoleEnabled && !this->textEnabled) return;
+
+	RateLimit& limit = this->rateLimits[record.format];
+	if (record.time >= limit.windowStart + 1000) {
+		if (limit.suppressed > 0) this->writeSuppressed(limit, record.time);
+		limit.windowStart = record.time;
+		limit.count = 0;
+	}
+	limit.count++;
+	if (limit.count > RATE_LIMIT) {
+		limit.suppressed++;
+		limit.lastRecord = record;
+		return;
+	}
+
+	this->text.clear();
+	AsyncLogger::formatRecord(record, this->text);
+	this->writeText(record.level, record.time, this->text);
+}
+
+void AsyncLogger::flushRateLimits(uint64_t now, bool force)
+{
+	if (!force && now < this->lastRateLimitFlush + 100) return;
+	this->lastRateLimitFlush = now;
+
+	for (auto& entry : this->rateLimits) {
+		RateLimit& limit = entry.second;
+		if (limit.suppressed == 0) continue;
+		if (!force && now < limit.windowStart + 1000) continue;
+		this->writeSuppressed(limit, now);
+	}
+}
+
+void AsyncLogger::writeSuppressed(RateLimit& limit, uint64_t now)
+{
+	this->text.clear();
+	AsyncLogger::formatRecord(limit.lastRecord, this->text);
+	this->text += " (" + ofToString(limit.suppressed) + " similar messages suppressed)";
+	this->writeText(limit.lastRecord.level, now, this->text);
+	limit.suppressed = 0;
+}
+
+void AsyncLogger::writeText(int level, uint64_t time, const string& text)
+{
+	static const ofLogLevel OF_LEVELS[] = { OF_LOG_VERBOSE, OF_LOG_NOTICE, OF_LOG_WARNING, OF_LOG_ERROR };
+	static const char* LEVEL_NAMES[] = { "verbose", "notice", "warning", "error" };
+	level = (int)ofClamp(level, LOG_LEVEL_VERBOSE, LOG_LEVEL_ERROR);
+
+	if (this->consoleEnabled) ofLog(OF_LEVELS[level], text);
+	if (!this->textEnabled) return;
+
+	char stamp[32];
+	snprintf(stamp, sizeof(stamp), "%llu.%03llu ", (unsigned long long)(time / 1000), (unsigned long long)(time % 1000));
+	this->lock();
+	if (this->textFile.is_open()) {
+		this->textFile << stamp << "[" << LEVEL_NAMES[level] << "] " << text << "\n";
+		this->textFile.flush();
+	}
+	this->unlock();
+}
+
+// Binary file: magic, version, then records
+//   'F' uint32 format id, uint32 length, format text      (first time a format shows up)
+//   'R' uint64 time, uint8 level, uint32 format id, uint8 argument count, then per argument
+//       uint8 type and int64 / double / uint16 length + text
+// Native byte order, the file is meant to be converted on the machine which wrote it.
+void AsyncLogger::writeBinary(const Record& record)
+{
+	auto put = [this](const void* data, size_t size) {
+		const char* bytes = (const char*)data;
+		this->binaryRecord.insert(this->binaryRecord.end(), bytes, bytes + size);
+	};
+	this->binaryRecord.clear();
+
+	auto format = this->binaryFormats.find(record.format);
+	uint32_t formatId;
+	if (format == this->binaryFormats.end()) {
+		formatId = this->binaryFormats.size();
+		this->binaryFormats[record.format] = formatId;
+		uint32_t length = strlen(record.format);
+		this->binaryRecord.push_back('F');
+		put(&formatId, 4);
+		put(&length, 4);
+		put(record.format, length);
+	}
+	else {
+		formatId = format->second;
+	}
+
+	uint8_t level = record.level;
+	uint8_t argumentCount = record.argumentCount;
+	this->binaryRecord.push_back('R');
+	put(&record.time, 8);
+	put(&level, 1);
+	put(&formatId, 4);
+	put(&argumentCount, 1);
+	const char* strings = record.strings;
+	for (int i = 0; i < record.argumentCount; i++) {
+		put(&record.types[i], 1);
+		if (record.types[i] == INTEGER) put(&record.integers[i], 8);
+		else if (record.types[i] == REAL) put(&record.reals[i], 8);
+		else {
+			uint16_t length = strlen(strings);
+			put(&length, 2);
+			put(strings, length);
+			strings += length + 1;
+		}
+	}
+	this->binaryFile.write(this->binaryRecord.data(), this->binaryRecord.size());
+}
+
+bool AsyncLogger::convertBinaryLog(const string& binaryPath, const string& textPath)
+{
+	ifstream input(ofToDataPath(binaryPath).c_str(), ios::in | ios::binary);
+	ofstream output(ofToDataPath(textPath).c_str(), ios::out | ios::trunc);
+	if (!input.is_open() || !output.is_open()) return false;
+
+	char magic[4];
+	input.read(magic, 4);
+	if (!input || memcmp(magic, BINARY_MAGIC, 4) != 0 || input.get() != BINARY_VERSION) return false;
+
+	static const char* LEVEL_NAMES[] = { "verbose", "notice", "warning", "error" };
+	map<uint32_t, string> formats;
+	Record record;
+	string text;
+	char kind;
+	while (input.get(kind)) {
+		if (kind == 'F') {
+			uint32_t formatId, length;
+			input.read((char*)&formatId, 4);
+			input.read((char*)&length, 4);
+			if (!input || length > 65536) return false;
+			string& format = formats[formatId];
+			format.resize(length);
+			input.read(&format[0], length);
+			continue;
+		}
+		if (kind != 'R') return false;
+
+		uint8_t level, argumentCount;
+		uint32_t formatId;
+		input.read((char*)&record.time, 8);
+		input.read((char*)&level, 1);
+		input.read((char*)&formatId, 4);
+		input.read((char*)&argumentCount, 1);
+		if (!input || formats.count(formatId) == 0 || argumentCount > MAX_ARGUMENTS) return false;
+		record.level = min((int)level, (int)LOG_LEVEL_ERROR);
+		record.format = formats[formatId].c_str();
+		record.argumentCount = 0;
+		record.stringBytes = 0;
+		for (int i = 0; i < argumentCount; i++) {
+			uint8_t type;
+			input.read((char*)&type, 1);
+			if (type == INTEGER) {
+				int64_t value;
+				input.read((char*)&value, 8);
+				AsyncLogger::addArgument(record, value);
+			}
+			else if (type == REAL) {
+				double value;
+				input.read((char*)&value, 8);
+				AsyncLogger::addArgument(record, value);
+			}
+			else {
+				uint16_t length;
+				input.read((char*)&length, 2);
+				string value(length, 0);
+				if (length > 0) input.read(&value[0], length);
+				AsyncLogger::addArgument(record, value);
+			}
+		}
+		if (!input) return false;
+
+		text.clear();
+		AsyncLogger::formatRecord(record, text);
+		output << record.time / 1000 << "." << setfill('0') << setw(3) << record.time % 1000 << setfill(' ')
+			<< " [" << LEVEL_NAMES[record.level] << "] " << text << "\n";
+	}
+	return true;
+}
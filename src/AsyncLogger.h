@@ -0,0 +1,170 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <fstream>
+#include <type_traits>
+#include "ofMain.h"
+#include "MpscRing.h"
+
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+using namespace std;
+
+#define LOG_LEVEL_VERBOSE 0
+#define LOG_LEVEL_NOTICE 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_SILENT 4
+
+// Calls below LOG_LEVEL are compiled out, arguments included. Set it from the project (e.g. /D LOG_LEVEL=2)
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_NOTICE
+#endif
+
+// LOG_NOTICE("Sending {} to {}", value, address): {} is replaced by the next argument.
+// The format has to be a string literal, only its address is kept
+#if LOG_LEVEL <= LOG_LEVEL_VERBOSE
+#define LOG_VERBOSE(...) AsyncLogger::getInstance()->log(LOG_LEVEL_VERBOSE, __VA_ARGS__)
+#else
+#define LOG_VERBOSE(...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_NOTICE
+#define LOG_NOTICE(...) AsyncLogger::getInstance()->log(LOG_LEVEL_NOTICE, __VA_ARGS__)
+#else
+#define LOG_NOTICE(...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(...) AsyncLogger::getInstance()->log(LOG_LEVEL_WARNING, __VA_ARGS__)
+#else
+#define LOG_WARNING(...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) AsyncLogger::getInstance()->log(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+// Logging off the calling thread. A call only copies the format's address and the raw arguments into a
+// ring shared by all threads (strings up to STRING_BYTES in total); a background thread formats them and
+// writes them to the console (through ofLog) and / or a text file. A call never blocks: when the ring is
+// full the message is dropped, and counted.
+// The same format may print at most RATE_LIMIT times per second, the rest is summed up once the second is over
+// (those are never formatted, only the last one is kept).
+// In binary mode records go to the file unformatted, convertBinaryLog() turns such a file into text later.
+class AsyncLogger : public ofThread {
+public:
+	static AsyncLogger* getInstance();
+	~AsyncLogger();
+
+	template <typename... Arguments>
+	void log(int level, const char* format, const Arguments&... arguments) {
+		size_t ticket;
+		Record* record = this->records.prepare(ticket);
+		if (record == NULL) {
+			this->droppedRecords++;
+			return;
+		}
+		record->time = ofGetSystemTimeMillis();
+		record->level = level;
+		record->format = format;
+		record->argumentCount = 0;
+		record->stringBytes = 0;
+		addArguments(*record, arguments...);
+		this->records.push(ticket);
+	}
+
+	void setConsoleEnabled(bool consoleEnabled);
+	// Empty path closes the file, the same path again does nothing
+	void setTextFile(const string& path);
+	void setBinaryFile(const string& path);
+	string getBinaryFile();
+	// Writes whatever is queued, then stops the thread. For the end of the app
+	void stop();
+
+	static bool convertBinaryLog(const string& binaryPath, const string& textPath);
+
+	static const int CAPACITY = 1024;
+	static const int MAX_ARGUMENTS = 8;
+	static const int STRING_BYTES = 96;
+	static const int RATE_LIMIT = 5;
+
+private:
+	AsyncLogger();
+
+	enum ArgumentType { INTEGER, REAL, TEXT };
+
+	struct Record {
+		uint64_t time;
+		int level;
+		const char* format;
+		int argumentCount;
+		uint8_t types[MAX_ARGUMENTS];
+		int64_t integers[MAX_ARGUMENTS];
+		double reals[MAX_ARGUMENTS];
+		// Text arguments, one after the other, each null terminated
+		int stringBytes;
+		char strings[STRING_BYTES];
+	};
+
+	static void addArguments(Record& record) {}
+
+	template <typename First, typename... Rest>
+	static void addArguments(Record& record, const First& first, const Rest&... rest) {
+		addArgument(record, first);
+		addArguments(record, rest...);
+	}
+
+	template <typename T>
+	static typename enable_if<is_arithmetic<T>::value || is_enum<T>::value>::type addArgument(Record& record, T value) {
+		if (record.argumentCount == MAX_ARGUMENTS) return;
+		const int i = record.argumentCount++;
+		record.types[i] = is_floating_point<T>::value ? REAL : INTEGER;
+		record.integers[i] = (int64_t)value;
+		record.reals[i] = (double)value;
+	}
+	static void addArgument(Record& record, const char* value);
+	static void addArgument(Record& record, const string& value);
+
+	// Appends format to output with every {} replaced by the next argument
+	static void formatRecord(const Record& record, string& output);
+
+	MpscRing<Record> records;
+	atomic<int> droppedRecords;
+
+	// ------ Background thread ------
+	void threadedFunction();
+	void drain();
+	void write(const Record& record);
+	void writeText(int level, uint64_t time, const string& text);
+	void writeBinary(const Record& record);
+	// Reports what the rate limit held back in windows which are over (all of them when force is set)
+	void flushRateLimits(uint64_t now, bool force);
+
+	struct RateLimit {
+		uint64_t windowStart;
+		int count;
+		int suppressed;
+		Record lastRecord;
+	};
+	void writeSuppressed(RateLimit& limit, uint64_t now);
+	map<const char*, RateLimit> rateLimits;
+	uint64_t lastRateLimitFlush;
+	int reportedDroppedRecords;
+	string text;
+
+	// Formats already written to the binary file, by address
+	map<const char*, uint32_t> binaryFormats;
+	vector<char> binaryRecord;
+
+	// Outputs. The files are only written & changed under the thread's lock, the rest of the thread runs without it
+	atomic<bool> consoleEnabled;
+	atomic<bool> textEnabled;
+	string textPath;
+	string binaryPath;
+	ofstream textFile;
+	ofstream binaryFile;
+};
+
+#endif
@@ -5,15 +5,34 @@ BodiesManager::BodiesManager()
 	this->initKinect();
 	TrackedBody::initialize();
 
-	// Body contour finder setup
-	contourFinder.setMinAreaRadius(10);
-	contourFinder.setMaxAreaRadius(1000);
-	contourFinder.setThreshold(15);
+	// Compile body shaders and allocate their FBOs now, rather than when someone walks in
+	GpuResourcePool::getInstance()->preload({ "hlines", "vlines", "grid", "dots" }, Constants::DEPTH_WIDTH, Constants::DEPTH_HEIGHT, 2);
+
+	// Every body we can ever need is built now, then recycled
+	for (int i = 0; i < Constants::MAX_TRACKED_BODIES; i++) {
+		this->localBodyPool.add(new TrackedBody(i, 0.75, 400, 2, false));
+	}
+	// Every other site may show all of its bodies at once: tracked bodies and playing shadows
+	for (int i = 0; i < (Constants::MAX_PEER_SITES - 1) * PeerNetworkManager::SITE_BODY_IDS; i++) {
+		this->remoteBodyPool.add(new TrackedBody(i, 0.75, 400, 2, true));
+	}
+	for (int i = 0; i < Constants::MAX_BODY_RECORDINGS; i++) {
+		this->shadowPool.add(new TrackedBodyShadow(Constants::BODY_RECORDINGS_ID_OFFSET + i, 0.75, 400, 2));
+	}
+
+	// Body contour tracer setup
+	contourTracer.setMinAreaRadius(10);
 
 	// Remote bodies intersection setup
 	bodiesIntersectionPath = new ofPath();
 	bodiesIntersectionActive = false;
 	bodiesIntersectionStartTimestamp = 0;
+	rasterIntersectionEnabled = true;
+	contourTransmissionError = 0;
+	pairedRemoteBodyId = -1;
+	maskTransportEnabled = false;
+	maskTransportScale = 1;
+	bodiesIntersectionImage.allocate(Constants::DEPTH_WIDTH, Constants::DEPTH_HEIGHT, OF_IMAGE_COLOR_ALPHA);
 }
 
 void BodiesManager::initKinect()
@@ -54,11 +73,29 @@ void BodiesManager::setBodyContourPolygonFidelity(int bodyContourPolygonFidelity
 	this->bodyContourPolygonFidelity = bodyContourPolygonFidelity;
 }
 
+void BodiesManager::setContourTransmissionError(float contourTransmissionError)
+{
+	this->contourTransmissionError = contourTransmissionError;
+}
+
+void BodiesManager::setMaskTransport(bool maskTransportEnabled, int maskScale)
+{
+	this->maskTransportEnabled = maskTransportEnabled;
+	this->maskTransportScale = maskScale;
+}
+
+void BodiesManager::setRasterIntersectionEnabled(bool rasterIntersectionEnabled)
+{
+	this->rasterIntersectionEnabled = rasterIntersectionEnabled;
+}
+
 //------ Per frame updates ------
 
 void BodiesManager::update()
 {
 	this->kinect.update();
+	// Everything sent to MaxMSP from here on is stamped with this frame's time and goes out at the end, together
+	this->maxMSPNetworkManager->beginFrame();
 	this->detectBodies();
 	this->computeBodyContours();
 
@@ -67,8 +104,11 @@ void BodiesManager::update()
 	this->updateRemoteBodies();
 
 	this->updateBodiesIntersection();
+	this->updateBodyOverlaps();
 
 	this->resolveInstrumentConflicts();
+
+	this->maxMSPNetworkManager->flush();
 }
 
 void BodiesManager::detectBodies() {
@@ -80,25 +120,33 @@ void BodiesManager::detectBodies() {
 	for (auto& body : bodies) {
 		if (body.tracked) {
 			// Update body skeleton data for tracked bodies
-			this->trackedBodyIds.push_back(body.bodyId);
-
 			if (this->trackedBodies.find(body.bodyId) == this->trackedBodies.end()) {
-				this->trackedBodies[body.bodyId] = new TrackedBody(body.bodyId, 0.75, 400, 2, false);
+				TrackedBody* newBody = this->localBodyPool.acquire(body.bodyId);
+				if (newBody == NULL) {
+					LOG_WARNING("Local body pool exhausted, ignoring body {}", body.bodyId);
+					continue;
+				}
+				this->trackedBodies[body.bodyId] = newBody;
 				this->trackedBodies[body.bodyId]->setOSCManager(this->maxMSPNetworkManager);
+				this->trackedBodies[body.bodyId]->setSiteId(this->peerNetworkManager->getSiteId());
 				this->trackedBodies[body.bodyId]->setIsTracked(true);
 
-				this->maxMSPNetworkManager->sendNewBody(this->trackedBodies[body.bodyId]->getInstrumentId());
+				this->maxMSPNetworkManager->sendNewBody(this->trackedBodies[body.bodyId]->getSoundId());
 			}
 
+			this->trackedBodyIds.push_back(body.bodyId);
 			this->trackedBodies[body.bodyId]->updateSkeletonData(body.joints, coordinateMapper);
 			this->trackedBodies[body.bodyId]->setNumberOfContourPoints(this->bodyContourPolygonFidelity);
+			// The mask replaces whatever contour would be sent, don't bother simplifying it
+			this->trackedBodies[body.bodyId]->setContourTransmissionError(this->maskTransportEnabled ? 0 : this->contourTransmissionError);
 		}
 		else {
 			// Remove untracked bodies from map
 			for (auto it = oldTrackedBodyIds.begin(); it != oldTrackedBodyIds.end(); ++it) {
 				int index = *it;
-				if (index == body.bodyId) {
+				if (index == body.bodyId && this->trackedBodies.find(index) != this->trackedBodies.end()) {
 					this->trackedBodies[index]->setIsTracked(false);
+					this->localBodyPool.release(this->trackedBodies[index]);
 					this->trackedBodies.erase(index);
 				}
 			}
@@ -107,20 +155,15 @@ void BodiesManager::detectBodies() {
 }
 
 void BodiesManager::computeBodyContours() {
-	int previewWidth = DEPTH_WIDTH;
-	int previewHeight = DEPTH_HEIGHT;
+	// One scan of the body index frame gives us the contours of all bodies
+	contourTracer.findContours(kinect.getBodyIndexSource()->getPixels());
 
-	// WARNING: This code works under the assumption that there is only one tracked body
-	// (this is our installation setup.)
 	for (int i = 0; i < this->trackedBodyIds.size(); i++) {
 		const int bodyId = this->trackedBodyIds[i];
-		contourFinder.setUseTargetColor(true);
-		contourFinder.setTargetColor(ofColor(bodyId));
-		contourFinder.setThreshold(0);
-		contourFinder.findContours(kinect.getBodyIndexSource()->getPixels());
+		if (!contourTracer.hasContour(bodyId)) continue;
 
 		TrackedBody* currentBody = this->trackedBodies[bodyId];
-		currentBody->updateContourData(contourFinder.getPolylines());
+		currentBody->updateContourData(contourTracer.getLargestContour(bodyId));
 	}
 }
 
@@ -136,9 +179,13 @@ void BodiesManager::updateTrackedBodies()
 		this->trackedBodies[bodyId]->sendDataToMaxMSP();
 
 		// Send serialized body data over the network (every 3 frames seems enough)
-		string data = this->trackedBodies[bodyId]->serialize();
-		if (ofGetFrameNum() % 3 == 0)
-			this->peerNetworkManager->sendBodyData(bodyId, data);
+		if (ofGetFrameNum() % 3 == 0) {
+			this->trackedBodies[bodyId]->serialize(this->outgoingFrame);
+			if (this->maskTransportEnabled && this->contourTracer.hasContour(bodyId)) {
+				this->outgoingFrame.setMask(this->kinect.getBodyIndexSource()->getPixels(), bodyId, this->maskTransportScale);
+			}
+			this->peerNetworkManager->sendBodyData(bodyId, this->outgoingFrame);
+		}
 	}
 
 	TrackedBody* leftBody = this->getLeftBody();
@@ -160,9 +207,10 @@ void BodiesManager::updateBodyShadows()
 			rec->sendDataToMaxMSP();
 
 			// Send serialized body data over the network
-			string data = rec->serialize();
-			if (ofGetFrameNum() % 3 == 1)
-				this->peerNetworkManager->sendBodyData(rec->index, data);
+			if (ofGetFrameNum() % 3 == 1) {
+				rec->serialize(this->outgoingFrame);
+				this->peerNetworkManager->sendBodyData(rec->index, this->outgoingFrame);
+			}
 		}
 	}
 
@@ -179,7 +227,7 @@ void BodiesManager::updateBodyShadows()
 			TrackedBody* body = this->trackedBodies[trackedBodyId];
 			rec->updateSkeletonData(body->latestSkeleton, body->coordinateMapper);
 			rec->setNumberOfContourPoints(this->bodyContourPolygonFidelity);
-			rec->updateContourData({ body->rawContour });
+			rec->updateContourData(body->rawContour);
 		}
 	}
 
@@ -220,24 +268,40 @@ void BodiesManager::updateBodyShadows()
 
 void BodiesManager::updateRemoteBodies()
 {
-	// Get data from peer and forward to MaxMSP
-	for (int bodyId = 0; bodyId < Constants::MAX_BODY_RECORDINGS + Constants::BODY_RECORDINGS_ID_OFFSET; bodyId++) {
+	// Get data from the peers and forward to MaxMSP
+	const vector<int>& remoteBodyIds = this->peerNetworkManager->getBodyIds();
+	for (int i = 0; i < remoteBodyIds.size(); i++) {
+		const int bodyId = remoteBodyIds[i];
 		if (!this->peerNetworkManager->isBodyActive(bodyId)) {
 			if (this->remoteBodies.find(bodyId) != this->remoteBodies.end()) {
 				this->remoteBodies[bodyId]->setIsTracked(false);
+				this->remoteBodyPool.release(this->remoteBodies[bodyId]);
 				this->remoteBodies.erase(bodyId);
 			}
 		}
 		else {
-			string bodyData = this->peerNetworkManager->getBodyData(bodyId);
-			if (bodyData.size() < 2) continue;
+			const BodyFrame* bodyData = this->peerNetworkManager->getBodyData(bodyId);
+			if (bodyData == NULL) continue;
 			if (this->remoteBodies.find(bodyId) == this->remoteBodies.end()) {
-				this->remoteBodies[bodyId] = new TrackedBody(bodyId, 0.75, 400, 2, true);
+				TrackedBody* newBody = this->remoteBodyPool.acquire(bodyId);
+				if (newBody == NULL) {
+					LOG_WARNING("Remote body pool exhausted, ignoring body {}", bodyId);
+					continue;
+				}
+				this->remoteBodies[bodyId] = newBody;
 				this->remoteBodies[bodyId]->setOSCManager(this->maxMSPNetworkManager);
+				this->remoteBodies[bodyId]->setSiteId(bodyId / PeerNetworkManager::SITE_BODY_IDS);
 				this->remoteBodies[bodyId]->setIsTracked(true);
-				this->maxMSPNetworkManager->sendNewBody(this->remoteBodies[bodyId]->getInstrumentId());
 			}
-			this->remoteBodies[bodyId]->deserialize(bodyData);
+			// The peer only sends every few frames, match the contour again only when something new came in
+			const BodyFrame* newBodyData = this->peerNetworkManager->takeNewBodyData(bodyId);
+			if (newBodyData != NULL) {
+				// Announced once its instrument came in with the data
+				const int previousSoundId = this->remoteBodies[bodyId]->getSoundId();
+				this->remoteBodies[bodyId]->deserialize(*newBodyData);
+				const int soundId = this->remoteBodies[bodyId]->getSoundId();
+				if (soundId >= 0 && soundId != previousSoundId) this->maxMSPNetworkManager->sendNewBody(soundId);
+			}
 			this->remoteBodies[bodyId]->update();
 			this->remoteBodies[bodyId]->sendDataToMaxMSP();
 		}
@@ -251,22 +315,25 @@ void BodiesManager::updateBodiesIntersection() {
 	if (body == NULL || remoteMainBody == NULL) {
 		bodiesIntersectionActive = false;
 		this->bodiesIntersectionPath->clear();
+		this->bodiesIntersectionMask.clear();
 		return;
 	}
 
-	this->bodiesIntersectionClipper.Clear();
-
-	body->contour.close();
-	remoteMainBody->contour.close();
-
-	this->bodiesIntersectionClipper.addPolyline(body->contour, ClipperLib::ptSubject);
-	this->bodiesIntersectionClipper.addPolyline(remoteMainBody->contour, ClipperLib::ptClip);
-	auto intersection = bodiesIntersectionClipper.getClipped(ClipperLib::ClipType::ctIntersection);
+	float normalizedArea = 0;
+	int noPolys = 0;
+	bool intersects;
+	if (this->rasterIntersectionEnabled) {
+		this->bodiesIntersectionPath->clear();
+		intersects = this->computeRasterIntersection(body, remoteMainBody, normalizedArea, noPolys);
+	}
+	else {
+		this->bodiesIntersectionMask.clear();
+		intersects = this->computeClipperIntersection(body, remoteMainBody, normalizedArea, noPolys);
+	}
 
-	if (intersection.size() == 0) {
+	if (!intersects) {
 		if (bodiesIntersectionActive) this->maxMSPNetworkManager->sendBodyIntersection(0, 0, 0);
 		bodiesIntersectionActive = false;
-		this->bodiesIntersectionPath->clear();
 		return;
 	}
 
@@ -275,7 +342,22 @@ void BodiesManager::updateBodiesIntersection() {
 		bodiesIntersectionStartTimestamp = ofGetSystemTimeMillis();
 	}
 
+	float duration = (1.0 * ofGetSystemTimeMillis() - bodiesIntersectionStartTimestamp) / 1000.0;
+
+	this->maxMSPNetworkManager->sendBodyIntersection(normalizedArea, noPolys, duration);
+}
+
+bool BodiesManager::computeClipperIntersection(TrackedBody* body, TrackedBody* remoteBody, float& normalizedArea, int& noPolys)
+{
+	this->bodiesIntersectionClipper.Clear();
+
+	this->bodiesIntersectionClipper.addPolyline(body->getContourPolyline(), ClipperLib::ptSubject);
+	this->bodiesIntersectionClipper.addPolyline(remoteBody->getContourPolyline(), ClipperLib::ptClip);
+	auto intersection = bodiesIntersectionClipper.getClipped(ClipperLib::ClipType::ctIntersection);
+
 	this->bodiesIntersectionPath->clear();
+	if (intersection.size() == 0) return false;
+
 	float totalArea = 0;
 	for (auto& line : intersection) {
 		this->bodiesIntersectionPath->moveTo(line[0]);
@@ -287,11 +369,74 @@ void BodiesManager::updateBodiesIntersection() {
 	}
 
 	float localBodyArea = fabs(body->contour.getArea());
-	float remoteBodyArea = fabs(remoteMainBody->contour.getArea());
-	float normalizedArea = (totalArea / (fmin(localBodyArea, remoteBodyArea)));
-	float duration = (1.0 * ofGetSystemTimeMillis() - bodiesIntersectionStartTimestamp) / 1000.0;
+	float remoteBodyArea = fabs(remoteBody->contour.getArea());
+	normalizedArea = (totalArea / (fmin(localBodyArea, remoteBodyArea)));
+	noPolys = intersection.size();
+	return true;
+}
+
+bool BodiesManager::computeRasterIntersection(TrackedBody* body, TrackedBody* remoteBody, float& normalizedArea, int& noPolys)
+{
+	this->localBodyMask.rasterize(body->contour);
+	// Remote contours only change when the peer sends a new frame
+	auto cached = this->remoteBodyMasks.find(remoteBody->index);
+	if (cached == this->remoteBodyMasks.end()) {
+		cached = this->remoteBodyMasks.insert(make_pair(remoteBody->index, RemoteBodyMask())).first;
+		cached->second.source = NULL;
+		cached->second.dataFrame = 0;
+	}
+	RemoteBodyMask& remoteBodyMask = cached->second;
+	if (remoteBody != remoteBodyMask.source || remoteBody->getDataFrame() != remoteBodyMask.dataFrame) {
+		remoteBodyMask.mask.rasterize(remoteBody->contour);
+		remoteBodyMask.source = remoteBody;
+		remoteBodyMask.dataFrame = remoteBody->getDataFrame();
+	}
+
+	// Disjoint bounding boxes (the common case) return before touching any mask words
+	int totalArea = this->bodiesIntersectionMask.intersect(this->localBodyMask, remoteBodyMask.mask);
+	if (totalArea == 0) return false;
+
+	this->bodiesIntersectionMask.toPixels(this->bodiesIntersectionImage.getPixels(), Colors::YELLOW);
+	this->bodiesIntersectionImage.update();
+
+	normalizedArea = 1.0 * totalArea / min(this->localBodyMask.getArea(), remoteBodyMask.mask.getArea());
+	noPolys = this->bodiesIntersectionMask.countComponents();
+	return true;
+}
+
+void BodiesManager::updateBodyOverlaps() {
+	this->bodyOverlapDetector.begin();
+
+	// Local bodies & shadows are numbered the way the other sites number them as remote bodies,
+	// so a pair keeps the same id everywhere
+	const int siteBodyOffset = this->peerNetworkManager->getSiteId() * PeerNetworkManager::SITE_BODY_IDS;
+
+	for (int i = 0; i < this->trackedBodyIds.size(); i++) {
+		const int bodyId = this->trackedBodyIds[i];
+		this->bodyOverlapDetector.addBody(siteBodyOffset + bodyId, this->trackedBodies[bodyId]);
+	}
+
+	for (auto it = this->remoteBodies.begin(); it != this->remoteBodies.end(); ++it) {
+		if (!this->peerNetworkManager->isBodyActive(it->first)) continue;
+		this->bodyOverlapDetector.addBody(it->first, it->second);
+	}
+
+	// Recording shadows are copies of the local body, they only take part once they play
+	for (auto it = this->activeBodyShadows.begin(); it != this->activeBodyShadows.end(); ++it) {
+		TrackedBodyShadow* rec = *it;
+		if (!rec->getIsPlaying()) continue;
+		this->bodyOverlapDetector.addBody(siteBodyOffset + rec->index, rec);
+	}
+
+	this->bodyOverlapDetector.detect();
+
+	for (auto& overlap : this->bodyOverlapDetector.getOverlaps()) {
+		this->maxMSPNetworkManager->sendBodyPairIntersection(overlap.firstKey, overlap.secondKey, overlap.firstSoundId, overlap.secondSoundId, overlap.normalizedArea, overlap.noPolys, overlap.duration);
+	}
 
-	this->maxMSPNetworkManager->sendBodyIntersection(normalizedArea, intersection.size(), duration);
+	for (auto& overlap : this->bodyOverlapDetector.getEndedOverlaps()) {
+		this->maxMSPNetworkManager->sendBodyPairIntersection(overlap.firstKey, overlap.secondKey, overlap.firstSoundId, overlap.secondSoundId, 0, 0, 0);
+	}
 }
 
 void BodiesManager::resolveInstrumentConflicts() {
@@ -319,10 +464,10 @@ void BodiesManager::drawTrackedBodies() {
 }
 
 void BodiesManager::drawRemoteBodies() {
-	for (int bodyId = 0; bodyId < Constants::MAX_BODY_RECORDINGS + Constants::BODY_RECORDINGS_ID_OFFSET; bodyId++) {
-		if (!this->peerNetworkManager->isBodyActive(bodyId)) continue;
+	for (auto it = this->remoteBodies.begin(); it != this->remoteBodies.end(); ++it) {
+		if (!this->peerNetworkManager->isBodyActive(it->first)) continue;
 
-		TrackedBody* body = this->remoteBodies[bodyId];
+		TrackedBody* body = it->second;
 		if (body->getIsRecording()) {
 			if (this->getLeftBody() == this->getRemoteBody()) {
 				body->setGeneralColor(Colors::BLUE_SHADOW);
@@ -349,6 +494,11 @@ void BodiesManager::drawBodyShadows() {
 }
 
 void BodiesManager::drawBodiesIntersection() {
+	if (this->rasterIntersectionEnabled) {
+		if (!this->bodiesIntersectionMask.isEmpty()) this->bodiesIntersectionImage.draw(0, 0);
+		return;
+	}
+
 	this->bodiesIntersectionPath->setFillColor(Colors::YELLOW);
 	this->bodiesIntersectionPath->setFilled(true);
 	this->bodiesIntersectionPath->draw();
@@ -357,6 +507,15 @@ void BodiesManager::drawBodiesIntersection() {
 
 // ------ Body getters ------
 
+string BodiesManager::getBodyPoolStats()
+{
+	stringstream ss;
+	ss << "local " << this->localBodyPool.getLiveCount() << "/" << this->localBodyPool.getPeakCount() << "/" << this->localBodyPool.getCapacity();
+	ss << ", remote " << this->remoteBodyPool.getLiveCount() << "/" << this->remoteBodyPool.getPeakCount() << "/" << this->remoteBodyPool.getCapacity();
+	ss << ", shadows " << this->shadowPool.getLiveCount() << "/" << this->shadowPool.getPeakCount() << "/" << this->shadowPool.getCapacity();
+	return ss.str();
+}
+
 TrackedBody* BodiesManager::getLocalBody()
 {
 	if (this->trackedBodyIds.size() > 0) {
@@ -368,16 +527,21 @@ TrackedBody* BodiesManager::getLocalBody()
 
 TrackedBody* BodiesManager::getRemoteBody()
 {
-	TrackedBody* remoteBody = NULL;
-
-	for (int bodyId = 0; bodyId < Constants::MAX_BODY_RECORDINGS + Constants::BODY_RECORDINGS_ID_OFFSET; bodyId++) {
-		if (!this->peerNetworkManager->isBodyActive(bodyId)) continue;
-		TrackedBody* body = this->remoteBodies[bodyId];
-		if (body->getIsRecording()) continue;
-		remoteBody = body;
+	// With several sites, ours is paired with one remote body: the same one for as long as it's there,
+	// then the one with the lowest id (lowest site first)
+	auto paired = this->remoteBodies.find(this->pairedRemoteBodyId);
+	if (paired != this->remoteBodies.end() && this->peerNetworkManager->isBodyActive(paired->first) && !paired->second->getIsRecording()) {
+		return paired->second;
 	}
 
-	return remoteBody;
+	this->pairedRemoteBodyId = -1;
+	for (auto it = this->remoteBodies.begin(); it != this->remoteBodies.end(); ++it) {
+		if (!this->peerNetworkManager->isBodyActive(it->first)) continue;
+		if (it->second->getIsRecording()) continue;
+		this->pairedRemoteBodyId = it->first;
+		return it->second;
+	}
+	return NULL;
 }
 
 TrackedBody* BodiesManager::getLeftBody()
@@ -422,6 +586,7 @@ void BodiesManager::clearBodyShadow(int index)
 	if (index >= this->activeBodyShadows.size()) return;
 
 	this->activeBodyShadows[index]->removeInstrument();
+	this->shadowPool.release(this->activeBodyShadows[index]);
 	this->activeBodyShadows.erase(this->activeBodyShadows.begin() + index);
 	this->activeBodyShadowsParams.erase(this->activeBodyShadowsParams.begin() + index);
 }
@@ -434,10 +599,12 @@ void BodiesManager::spawnBodyShadow()
 	const int bodyId = originalBody->index;
 	const int recordingIndex = Constants::BODY_RECORDINGS_ID_OFFSET + this->activeBodyShadows.size();
 
-	TrackedBodyShadow* rec = new TrackedBodyShadow(recordingIndex, 0.75, 400, 2);
+	TrackedBodyShadow* rec = this->shadowPool.acquire(recordingIndex);
+	if (rec == NULL) return;
 
 	rec->setTrackedBodyIndex(bodyId);
 	rec->setOSCManager(this->maxMSPNetworkManager);
+	rec->setSiteId(this->peerNetworkManager->getSiteId());
 	rec->setIsTracked(true);
 	rec->setIsRecording(true);
 	rec->assignInstrument(instrumentId);
@@ -463,5 +630,5 @@ void BodiesManager::playBodyShadow(int index)
 	TrackedBody* originalBody = this->trackedBodies[originalBodyId];
 	originalBody->assignInstrument();
 	rec->startPlayLoop();
-	this->maxMSPNetworkManager->sendNewBody(rec->getInstrumentId());
+	this->maxMSPNetworkManager->sendNewBody(rec->getSoundId());
 }
@@ -4,8 +4,14 @@
 #include "Sequencer.h"
 #include "TrackedBody.h"
 #include "TrackedBodyShadow.h"
+#include "BodyContourTracer.h"
+#include "BodyMask.h"
+#include "BodyOverlapDetector.h"
+#include "BodyPool.h"
 #include "Constants.h"
+#include "AsyncLogger.h"
 #include "ofxKinectForWindows2.h"
+#include "ofxClipper.h"
 #include "MaxMSPNetworkManager.h"
 #include "PeerNetworkManager.h"
 
@@ -19,9 +25,16 @@ public:
 	void setIsLeftPlayer(bool isLeftPlayer);
 	void setAutomaticShadowsEnabled(bool automaticShadowsEnabled);
 	void setBodyContourPolygonFidelity(int bodyContourPolygonFidelity);
+	void setContourTransmissionError(float contourTransmissionError);
+	// Send local bodies to the peer as run-length encoded masks (downsampled by maskScale) instead of contours
+	void setMaskTransport(bool maskTransportEnabled, int maskScale);
+	void setRasterIntersectionEnabled(bool rasterIntersectionEnabled);
 
 	void update();
 
+	// Live / peak / capacity of each body pool
+	string getBodyPoolStats();
+
 	TrackedBody* getLocalBody();
 	int getLocalBodyIndex();
 
@@ -48,10 +61,15 @@ private:
 	bool isLeftPlayer;
 	bool automaticShadowsEnabled;
 	int bodyContourPolygonFidelity;
+	float contourTransmissionError;
+	bool maskTransportEnabled;
+	int maskTransportScale;
+	bool rasterIntersectionEnabled;
 
 	// Network managers
 	MaxMSPNetworkManager* maxMSPNetworkManager;
 	PeerNetworkManager* peerNetworkManager;
+	BodyFrame outgoingFrame;
 
 	// Updates at every frame
 	void detectBodies();
@@ -60,6 +78,9 @@ private:
 	void updateBodyShadows();
 	void updateRemoteBodies();
 	void updateBodiesIntersection();
+	bool computeClipperIntersection(TrackedBody* body, TrackedBody* remoteBody, float& normalizedArea, int& noPolys);
+	bool computeRasterIntersection(TrackedBody* body, TrackedBody* remoteBody, float& normalizedArea, int& noPolys);
+	void updateBodyOverlaps();
 	void resolveInstrumentConflicts();
 
 	// // Kinect, detecting body contours
@@ -67,7 +88,11 @@ private:
 	ICoordinateMapper* coordinateMapper;
 	void initKinect();
 
-	ofxCv::ContourFinder contourFinder;
+	BodyContourTracer contourTracer;
+
+	BodyPool<TrackedBody> localBodyPool;
+	BodyPool<TrackedBody> remoteBodyPool;
+	BodyPool<TrackedBodyShadow> shadowPool;
 
 	map<int, TrackedBody*> trackedBodies;
 	map<int, TrackedBody*> remoteBodies;
@@ -79,6 +104,24 @@ private:
 	float bodiesIntersectionStartTimestamp;
 	ofPath* bodiesIntersectionPath;
 
+	//// Same intersection on depth resolution bitmasks, much cheaper than clipping the polygons
+	BodyMask localBodyMask;
+	// One mask per remote body id, each rasterized again only when its body gets a new data frame.
+	// Entries stay once created, so switching between remote bodies doesn't allocate
+	struct RemoteBodyMask {
+		BodyMask mask;
+		TrackedBody* source;
+		uint64_t dataFrame;
+	};
+	map<int, RemoteBodyMask> remoteBodyMasks;
+	// Remote body ours is paired with, kept while it stays active
+	int pairedRemoteBodyId;
+	BodyMask bodiesIntersectionMask;
+	ofImage bodiesIntersectionImage;
+
+	//// Overlaps between every pair of active bodies (local, remote, shadows)
+	BodyOverlapDetector bodyOverlapDetector;
+
 	//// Body shadows management
 	vector<TrackedBodyShadow*> activeBodyShadows;
 	vector<pair<int, pair<float, float> > > activeBodyShadowsParams;
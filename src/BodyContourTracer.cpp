@@ -0,0 +1,154 @@
+#include "BodyContourTracer.h"
+
+// 8-neighbourhood, in counterclockwise order (on screen) starting from the east neighbour
+static const int NEIGHBOUR_DX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+static const int NEIGHBOUR_DY[8] = { 0, -1, -1, -1, 0, 1, 1, 1 };
+static const int DIRECTION_EAST = 0;
+static const int DIRECTION_WEST = 4;
+
+BodyContourTracer::BodyContourTracer()
+{
+	this->minArea = 0;
+	this->width = this->height = 0;
+	this->channels = 1;
+	this->labels = NULL;
+	this->contourCount = 0;
+	for (int i = 0; i < 256; i++) this->largestContours[i] = -1;
+}
+
+void BodyContourTracer::setMinAreaRadius(float minAreaRadius)
+{
+	this->minArea = PI * minAreaRadius * minAreaRadius;
+}
+
+void BodyContourTracer::findContours(const ofPixels& bodyIndexPixels)
+{
+	this->width = bodyIndexPixels.getWidth();
+	this->height = bodyIndexPixels.getHeight();
+	this->channels = bodyIndexPixels.getNumChannels();
+	this->labels = bodyIndexPixels.getData();
+
+	this->contourCount = 0;
+	for (int i = 0; i < 256; i++) this->largestContours[i] = -1;
+	this->marks.assign(this->width * this->height, 0);
+
+	if (this->labels == NULL) return;
+
+	for (int y = 0; y < this->height; y++) {
+		const unsigned char* row = this->labels + y * this->width * this->channels;
+		unsigned char previousLabel = BACKGROUND_LABEL;
+
+		for (int x = 0; x < this->width; x++) {
+			unsigned char label = row[x * this->channels];
+			if (label == BACKGROUND_LABEL || label == previousLabel) {
+				previousLabel = label;
+				continue;
+			}
+			previousLabel = label;
+
+			// Start of a run which hasn't been visited yet: either the outer border of a new body
+			// region, or the border of a hole inside a region we've already traced.
+			if (this->marks[y * this->width + x] != 0) continue;
+
+			float area = this->traceBorder(x, y, label);
+
+			// Outer borders are followed clockwise (negative area on screen), holes counterclockwise.
+			if (-area < this->minArea || area >= 0) continue;
+
+			if (this->contourCount == this->contours.size()) this->contours.push_back(ContourBuffer());
+			swap(this->contours[this->contourCount], this->currentContour);
+
+			if (this->largestContours[label] < 0 || -area > this->largestAreas[label]) {
+				this->largestContours[label] = this->contourCount;
+				this->largestAreas[label] = -area;
+			}
+			this->contourCount++;
+		}
+	}
+}
+
+int BodyContourTracer::getLabel(int x, int y)
+{
+	if (x < 0 || y < 0 || x >= this->width || y >= this->height) return BACKGROUND_LABEL;
+	return this->labels[(y * this->width + x) * this->channels];
+}
+
+// Follows the border starting at (x, y), which has a pixel of another label on its left.
+// Fills currentContour (collinear points skipped) and returns the signed area of the border.
+float BodyContourTracer::traceBorder(int x, int y, unsigned char label)
+{
+	this->currentContour.clear();
+
+	// Look clockwise around the start pixel for the first pixel of the same label
+	int firstDirection = -1;
+	for (int i = 0; i < 8; i++) {
+		int direction = (DIRECTION_WEST - i + 8) & 7;
+		if (this->getLabel(x + NEIGHBOUR_DX[direction], y + NEIGHBOUR_DY[direction]) == label) {
+			firstDirection = direction;
+			break;
+		}
+	}
+
+	if (firstDirection == -1) {
+		// Isolated pixel
+		this->marks[y * this->width + x] = -1;
+		return 0;
+	}
+
+	const int firstX = x + NEIGHBOUR_DX[firstDirection];
+	const int firstY = y + NEIGHBOUR_DY[firstDirection];
+
+	int currentX = x, currentY = y;
+	int previousDirection = firstDirection;
+	int incomingDirection = -1;
+	float doubleArea = 0;
+
+	while (true) {
+		// Look counterclockwise around the current pixel, starting after the previous one
+		int nextDirection = previousDirection;
+		bool eastIsBackground = false;
+		for (int i = 1; i <= 8; i++) {
+			int direction = (previousDirection + i) & 7;
+			if (this->getLabel(currentX + NEIGHBOUR_DX[direction], currentY + NEIGHBOUR_DY[direction]) == label) {
+				nextDirection = direction;
+				break;
+			}
+			if (direction == DIRECTION_EAST) eastIsBackground = true;
+		}
+
+		signed char& mark = this->marks[currentY * this->width + currentX];
+		if (eastIsBackground) mark = -1;
+		else if (mark == 0) mark = 1;
+
+		if (nextDirection != incomingDirection) {
+			this->currentContour.addPoint(currentX, currentY);
+		}
+
+		const int nextX = currentX + NEIGHBOUR_DX[nextDirection];
+		const int nextY = currentY + NEIGHBOUR_DY[nextDirection];
+		doubleArea += currentX * nextY - nextX * currentY;
+
+		if (nextX == x && nextY == y && currentX == firstX && currentY == firstY) break;
+
+		previousDirection = (nextDirection + 4) & 7;
+		incomingDirection = nextDirection;
+		currentX = nextX;
+		currentY = nextY;
+	}
+
+	return doubleArea / 2.0f;
+}
+
+// ------ Results of the latest frame ------
+
+bool BodyContourTracer::hasContour(int bodyId)
+{
+	if (bodyId < 0 || bodyId > 255) return false;
+	return this->largestContours[bodyId] >= 0;
+}
+
+const ContourBuffer& BodyContourTracer::getLargestContour(int bodyId)
+{
+	if (!this->hasContour(bodyId)) return this->emptyContour;
+	return this->contours[this->largestContours[bodyId]];
+}
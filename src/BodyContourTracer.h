@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ContourBuffer.h"
+
+#ifndef BODY_CONTOUR_TRACER_H
+#define BODY_CONTOUR_TRACER_H
+
+using namespace std;
+
+// Finds the outer contours of every body in the Kinect body index frame with a single scan.
+// Each pixel of the frame holds the index of the body it belongs to, or 255 for the background.
+// Border following is done with the Suzuki-Abe algorithm (same one OpenCV's findContours uses),
+// treating every pixel with a different label as background for the body being traced.
+class BodyContourTracer {
+public:
+	BodyContourTracer();
+	void setMinAreaRadius(float minAreaRadius);
+
+	void findContours(const ofPixels& bodyIndexPixels);
+
+	bool hasContour(int bodyId);
+	const ContourBuffer& getLargestContour(int bodyId);
+
+	static const unsigned char BACKGROUND_LABEL = 255;
+
+private:
+	float minArea;
+	int width, height, channels;
+	const unsigned char* labels;
+
+	// 0 - not visited, 1 - visited border pixel, -1 - visited border pixel with background on its right
+	vector<signed char> marks;
+
+	// Every contour of the latest frame. Buffers are kept from frame to frame and swapped in, never copied
+	vector<ContourBuffer> contours;
+	int contourCount;
+	// For every label, index of its largest contour (-1 for none) and that contour's area
+	int largestContours[256];
+	float largestAreas[256];
+	ContourBuffer currentContour;
+	ContourBuffer emptyContour;
+
+	int getLabel(int x, int y);
+	float traceBorder(int x, int y, unsigned char label);
+};
+
+#endif
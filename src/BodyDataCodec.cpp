@@ -0,0 +1,576 @@
+#include "BodyDataCodec.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BODY_DATA_CODEC_SSE
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+BodyFrame::BodyFrame()
+{
+	this->clear();
+}
+
+void BodyFrame::clear()
+{
+	this->index = 0;
+	this->isRecording = false;
+	this->instrumentId = -1;
+	this->sequence = 0;
+	this->captureTime = 0;
+	this->isInterpolated = false;
+	this->jointMask = 0;
+	this->contour.clear();
+	this->hasMask = false;
+	this->maskX = this->maskY = 0;
+	this->maskWidth = this->maskHeight = 0;
+	this->maskScale = 1;
+	this->mask.clear();
+}
+
+void BodyFrame::setJoint(JointType joint, ofVec2f position)
+{
+	if (joint < 0 || joint >= JointType_Count) return;
+	this->joints[joint] = position;
+	this->jointMask |= (1u << joint);
+}
+
+bool BodyFrame::hasJoint(int joint) const
+{
+	return (this->jointMask & (1u << joint)) != 0;
+}
+
+void BodyFrame::setMask(const ofPixels& bodyIndexPixels, unsigned char label, int scale)
+{
+	const int width = bodyIndexPixels.getWidth();
+	const int height = bodyIndexPixels.getHeight();
+	const int channels = bodyIndexPixels.getNumChannels();
+	const unsigned char* pixels = bodyIndexPixels.getData();
+	if (pixels == NULL || this->contour.size() == 0) return;
+
+	float minX = width, maxX = 0, minY = height, maxY = 0;
+	const float* x = this->contour.getX();
+	const float* y = this->contour.getY();
+	for (int i = 0; i < this->contour.size(); i++) {
+		minX = min(minX, x[i]);
+		maxX = max(maxX, x[i]);
+		minY = min(minY, y[i]);
+		maxY = max(maxY, y[i]);
+	}
+
+	// A pixel of margin, the contour runs through pixel centers
+	scale = max(scale, 1);
+	this->maskX = ofClamp(floor(minX) - 1, 0, width - 1);
+	this->maskY = ofClamp(floor(minY) - 1, 0, height - 1);
+	int right = ofClamp(ceil(maxX) + 1, this->maskX, width - 1);
+	int bottom = ofClamp(ceil(maxY) + 1, this->maskY, height - 1);
+	this->maskScale = scale;
+	this->maskWidth = (right - this->maskX) / scale + 1;
+	this->maskHeight = (bottom - this->maskY) / scale + 1;
+
+	// Each cell takes the pixel at its center
+	this->mask.resize(this->maskWidth * this->maskHeight);
+	for (int row = 0; row < this->maskHeight; row++) {
+		int py = min(this->maskY + row * scale + scale / 2, height - 1);
+		const unsigned char* source = pixels + py * width * channels;
+		uint8_t* cells = this->mask.data() + row * this->maskWidth;
+		for (int column = 0; column < this->maskWidth; column++) {
+			int px = min(this->maskX + column * scale + scale / 2, width - 1);
+			cells[column] = (source[px * channels] == label) ? 1 : 0;
+		}
+	}
+
+	this->hasMask = true;
+	this->contour.clear();
+}
+
+BodyDataCodec::BodyDataCodec()
+{
+	this->keyframeInterval = Constants::PEER_KEYFRAME_INTERVAL;
+	this->encodedBytes = 0;
+	this->keyframeCount = 0;
+	this->deltaCount = 0;
+	this->decodeErrors = 0;
+	this->missingKeyframes = 0;
+}
+
+void BodyDataCodec::setKeyframeInterval(int keyframeInterval)
+{
+	this->keyframeInterval = max(keyframeInterval, 1);
+}
+
+int BodyDataCodec::encode(const BodyFrame& frame, ofBuffer& buffer)
+{
+	const uint32_t sequence = ++this->sequences[frame.index];
+
+	if (frame.hasMask) {
+		this->bytes.clear();
+		this->writeHeader(frame, false, 0, sequence);
+		this->writeMask(frame);
+		buffer.set((const char*)this->bytes.data(), this->bytes.size());
+		this->encodedBytes += this->bytes.size();
+		return this->bytes.size();
+	}
+
+	const int noPoints = frame.contour.size();
+	const float* x = frame.contour.getX();
+	const float* y = frame.contour.getY();
+	this->quantizedX.resize(noPoints);
+	this->quantizedY.resize(noPoints);
+	for (int i = 0; i < noPoints; i++) {
+		this->quantizedX[i] = BodyDataCodec::quantize(x[i]);
+		this->quantizedY[i] = BodyDataCodec::quantize(y[i]);
+	}
+
+	KeyframeState& keyframe = this->encoderState[frame.index];
+	bool sendKeyframe = !keyframe.valid || keyframe.age >= this->keyframeInterval || keyframe.x.size() != noPoints || noPoints == 0;
+
+	if (!sendKeyframe) {
+		this->keyframeContour.resize(noPoints);
+		float* kx = this->keyframeContour.getX();
+		float* ky = this->keyframeContour.getY();
+		for (int i = 0; i < noPoints; i++) {
+			kx[i] = BodyDataCodec::dequantize(keyframe.x[i]);
+			ky[i] = BodyDataCodec::dequantize(keyframe.y[i]);
+		}
+		int offset = this->aligner.findBestOffset(this->keyframeContour, frame.contour);
+
+		this->bytes.clear();
+		this->writeHeader(frame, true, keyframe.id, sequence);
+		this->writeDeltaContour(keyframe, offset);
+
+		// After fast movement a delta can cost more than a keyframe, start over from a new one instead
+		if (this->bytes.size() > keyframe.size) {
+			sendKeyframe = true;
+		}
+		else {
+			keyframe.age++;
+			this->deltaCount++;
+		}
+	}
+
+	if (sendKeyframe) {
+		if (keyframe.valid) keyframe.id++;
+		keyframe.valid = true;
+		keyframe.age = 1;
+		keyframe.x = this->quantizedX;
+		keyframe.y = this->quantizedY;
+
+		this->bytes.clear();
+		this->writeHeader(frame, false, keyframe.id, sequence);
+		this->writeKeyframeContour();
+		keyframe.size = this->bytes.size();
+		this->keyframeCount++;
+	}
+
+	buffer.set((const char*)this->bytes.data(), this->bytes.size());
+	this->encodedBytes += this->bytes.size();
+	return this->bytes.size();
+}
+
+bool BodyDataCodec::decode(const ofBuffer& buffer, BodyFrame& frame)
+{
+	const uint8_t* p = (const uint8_t*)buffer.getData();
+	const uint8_t* end = p + buffer.size();
+
+	if (buffer.size() < BodyDataCodec::HEADER_SIZE || p[0] != BodyDataCodec::MAGIC || p[1] != BodyDataCodec::VERSION) {
+		this->decodeErrors++;
+		return false;
+	}
+
+	const bool isDelta = (p[2] & 2) != 0;
+	const int index = p[3];
+	const uint8_t keyframeId = p[5];
+	const uint32_t sequence = BodyDataCodec::readUInt32(p + 6);
+	const uint32_t captureTime = BodyDataCodec::readUInt32(p + 10);
+	const uint32_t jointMask = BodyDataCodec::readUInt32(p + 14);
+	int noJoints = 0;
+	for (int joint = 0; joint < JointType_Count; joint++) {
+		if (jointMask & (1u << joint)) noJoints++;
+	}
+
+	const uint8_t* jointData = p + BodyDataCodec::HEADER_SIZE;
+	const uint8_t* q = jointData + 4 * noJoints;
+	if ((jointMask >> JointType_Count) != 0 || q > end) {
+		this->decodeErrors++;
+		return false;
+	}
+
+	const bool isMask = (p[2] & 4) != 0;
+	uint32_t noPoints = 0;
+	int maskX, maskY, maskScale, maskWidth, maskHeight;
+	if (isMask) {
+		if (!this->readMask(q, end, maskX, maskY, maskScale, maskWidth, maskHeight)) {
+			this->decodeErrors++;
+			return false;
+		}
+	}
+	else {
+		if (!BodyDataCodec::readVarint(q, end, noPoints) || noPoints > 0xFFFF) {
+			this->decodeErrors++;
+			return false;
+		}
+
+		this->decodedX.resize(noPoints);
+		this->decodedY.resize(noPoints);
+
+		if (isDelta) {
+			auto it = this->decoderState.find(index);
+			if (it == this->decoderState.end() || !it->second.valid || it->second.id != keyframeId || it->second.x.size() != noPoints) {
+				this->missingKeyframes++;
+				return false;
+			}
+
+			const KeyframeState& keyframe = it->second;
+			uint32_t offset;
+			if (!BodyDataCodec::readVarint(q, end, offset) || (noPoints > 0 && offset >= noPoints)) {
+				this->decodeErrors++;
+				return false;
+			}
+			for (int i = 0; i < noPoints; i++) {
+				int k = (i + offset) % noPoints;
+				this->decodedX[k] = keyframe.x[i];
+				this->decodedY[k] = keyframe.y[i];
+			}
+			int i = 0;
+			while (i < noPoints) {
+				uint32_t skip;
+				if (!BodyDataCodec::readVarint(q, end, skip) || skip > noPoints - i) {
+					this->decodeErrors++;
+					return false;
+				}
+				i += skip;
+				if (i == noPoints) break;
+
+				int dx, dy;
+				if (!BodyDataCodec::readSignedVarint(q, end, dx) || !BodyDataCodec::readSignedVarint(q, end, dy)) {
+					this->decodeErrors++;
+					return false;
+				}
+				int k = (i + offset) % noPoints;
+				this->decodedX[k] += dx;
+				this->decodedY[k] += dy;
+				i++;
+			}
+		}
+		else {
+			int px = 0, py = 0;
+			for (int i = 0; i < noPoints; i++) {
+				int dx, dy;
+				if (!BodyDataCodec::readSignedVarint(q, end, dx) || !BodyDataCodec::readSignedVarint(q, end, dy)) {
+					this->decodeErrors++;
+					return false;
+				}
+				px += dx;
+				py += dy;
+				this->decodedX[i] = px;
+				this->decodedY[i] = py;
+			}
+		}
+
+	}
+
+	if (q != end) {
+		this->decodeErrors++;
+		return false;
+	}
+
+	if (!isDelta && !isMask) {
+		KeyframeState& keyframe = this->decoderState[index];
+		keyframe.id = keyframeId;
+		keyframe.valid = true;
+		keyframe.x = this->decodedX;
+		keyframe.y = this->decodedY;
+	}
+
+	frame.isRecording = (p[2] & 1) != 0;
+	frame.index = index;
+	frame.instrumentId = (int8_t)p[4];
+	frame.sequence = sequence;
+	frame.captureTime = captureTime;
+	frame.isInterpolated = false;
+	frame.jointMask = jointMask;
+
+	for (int joint = 0; joint < JointType_Count; joint++) {
+		if (!frame.hasJoint(joint)) continue;
+		frame.joints[joint].x = BodyDataCodec::dequantize((int16_t)BodyDataCodec::readUInt16(jointData));
+		frame.joints[joint].y = BodyDataCodec::dequantize((int16_t)BodyDataCodec::readUInt16(jointData + 2));
+		jointData += 4;
+	}
+
+	frame.hasMask = isMask;
+	if (isMask) {
+		frame.maskX = maskX;
+		frame.maskY = maskY;
+		frame.maskScale = maskScale;
+		frame.maskWidth = maskWidth;
+		frame.maskHeight = maskHeight;
+		swap(frame.mask, this->decodedMask);
+	}
+
+	frame.contour.resize(noPoints);
+	float* x = frame.contour.getX();
+	float* y = frame.contour.getY();
+	for (int i = 0; i < noPoints; i++) {
+		x[i] = BodyDataCodec::dequantize(this->decodedX[i]);
+		y[i] = BodyDataCodec::dequantize(this->decodedY[i]);
+	}
+
+	return true;
+}
+
+bool BodyDataCodec::peekSequence(const ofBuffer& buffer, int& index, uint32_t& sequence)
+{
+	const uint8_t* p = (const uint8_t*)buffer.getData();
+	if (buffer.size() < BodyDataCodec::HEADER_SIZE || p[0] != BodyDataCodec::MAGIC || p[1] != BodyDataCodec::VERSION) return false;
+	index = p[3];
+	sequence = BodyDataCodec::readUInt32(p + 6);
+	return true;
+}
+
+int BodyDataCodec::getEncodedBytes()
+{
+	return this->encodedBytes;
+}
+
+int BodyDataCodec::getKeyframeCount()
+{
+	return this->keyframeCount;
+}
+
+int BodyDataCodec::getDeltaCount()
+{
+	return this->deltaCount;
+}
+
+int BodyDataCodec::getDecodeErrors()
+{
+	return this->decodeErrors;
+}
+
+int BodyDataCodec::getMissingKeyframes()
+{
+	return this->missingKeyframes;
+}
+
+// ------ Encoding ------
+
+void BodyDataCodec::writeHeader(const BodyFrame& frame, bool isDelta, uint8_t keyframeId, uint32_t sequence)
+{
+	this->writeUInt8(BodyDataCodec::MAGIC);
+	this->writeUInt8(BodyDataCodec::VERSION);
+	this->writeUInt8((frame.isRecording ? 1 : 0) | (isDelta ? 2 : 0) | (frame.hasMask ? 4 : 0));
+	this->writeUInt8((uint8_t)frame.index);
+	this->writeUInt8((uint8_t)(int8_t)frame.instrumentId);
+	this->writeUInt8(keyframeId);
+	this->writeUInt32(sequence);
+	this->writeUInt32(frame.captureTime);
+	this->writeUInt32(frame.jointMask);
+
+	for (int joint = 0; joint < JointType_Count; joint++) {
+		if (!frame.hasJoint(joint)) continue;
+		this->writeUInt16((uint16_t)(int16_t)BodyDataCodec::quantize(frame.joints[joint].x));
+		this->writeUInt16((uint16_t)(int16_t)BodyDataCodec::quantize(frame.joints[joint].y));
+	}
+}
+
+void BodyDataCodec::writeKeyframeContour()
+{
+	const int noPoints = this->quantizedX.size();
+	this->writeVarint(noPoints);
+
+	int px = 0, py = 0;
+	for (int i = 0; i < noPoints; i++) {
+		this->writeSignedVarint(this->quantizedX[i] - px);
+		this->writeSignedVarint(this->quantizedY[i] - py);
+		px = this->quantizedX[i];
+		py = this->quantizedY[i];
+	}
+}
+
+void BodyDataCodec::writeDeltaContour(const KeyframeState& keyframe, int offset)
+{
+	const int noPoints = this->quantizedX.size();
+	this->writeVarint(noPoints);
+	this->writeVarint(offset);
+
+	// Points which didn't move since the keyframe are skipped
+	int skip = 0;
+	for (int i = 0; i < noPoints; i++) {
+		int k = (i + offset) % noPoints;
+		int dx = this->quantizedX[k] - keyframe.x[i];
+		int dy = this->quantizedY[k] - keyframe.y[i];
+		if (dx == 0 && dy == 0) {
+			skip++;
+			continue;
+		}
+		this->writeVarint(skip);
+		this->writeSignedVarint(dx);
+		this->writeSignedVarint(dy);
+		skip = 0;
+	}
+	if (skip > 0) this->writeVarint(skip);
+}
+
+void BodyDataCodec::writeMask(const BodyFrame& frame)
+{
+	this->writeUInt16(frame.maskX);
+	this->writeUInt16(frame.maskY);
+	this->writeUInt8(frame.maskScale);
+	this->writeUInt16(frame.maskWidth);
+	this->writeUInt16(frame.maskHeight);
+
+	for (int row = 0; row < frame.maskHeight; row++) {
+		const uint8_t* cells = frame.mask.data() + row * frame.maskWidth;
+
+		this->rowRuns.clear();
+		int x = BodyDataCodec::findRunEnd(cells, 0, frame.maskWidth, 0);
+		while (x < frame.maskWidth) {
+			int runEnd = BodyDataCodec::findRunEnd(cells, x, frame.maskWidth, 1);
+			this->rowRuns.push_back(x);
+			this->rowRuns.push_back(runEnd);
+			x = BodyDataCodec::findRunEnd(cells, runEnd, frame.maskWidth, 0);
+		}
+
+		this->writeVarint(this->rowRuns.size() / 2);
+		int previousEnd = 0;
+		for (int i = 0; i < this->rowRuns.size(); i += 2) {
+			this->writeVarint(this->rowRuns[i] - previousEnd);
+			this->writeVarint(this->rowRuns[i + 1] - this->rowRuns[i]);
+			previousEnd = this->rowRuns[i + 1];
+		}
+	}
+}
+
+bool BodyDataCodec::readMask(const uint8_t*& p, const uint8_t* end, int& maskX, int& maskY, int& maskScale, int& maskWidth, int& maskHeight)
+{
+	if (end - p < 9) return false;
+	maskX = BodyDataCodec::readUInt16(p);
+	maskY = BodyDataCodec::readUInt16(p + 2);
+	maskScale = p[4];
+	maskWidth = BodyDataCodec::readUInt16(p + 5);
+	maskHeight = BodyDataCodec::readUInt16(p + 7);
+	p += 9;
+	if (maskScale == 0 || maskWidth * maskScale > 2 * Constants::DEPTH_WIDTH || maskHeight * maskScale > 2 * Constants::DEPTH_HEIGHT) return false;
+
+	this->decodedMask.assign(maskWidth * maskHeight, 0);
+	for (int row = 0; row < maskHeight; row++) {
+		uint8_t* cells = this->decodedMask.data() + row * maskWidth;
+		uint32_t noRuns;
+		if (!BodyDataCodec::readVarint(p, end, noRuns)) return false;
+
+		uint32_t x = 0;
+		for (uint32_t run = 0; run < noRuns; run++) {
+			uint32_t gap, length;
+			if (!BodyDataCodec::readVarint(p, end, gap) || !BodyDataCodec::readVarint(p, end, length)) return false;
+			if (gap > maskWidth - x || length > maskWidth - x - gap) return false;
+			x += gap;
+			memset(cells + x, 1, length);
+			x += length;
+		}
+	}
+	return true;
+}
+
+// ------ Byte level helpers ------
+
+void BodyDataCodec::writeUInt8(uint8_t value)
+{
+	this->bytes.push_back(value);
+}
+
+void BodyDataCodec::writeUInt16(uint16_t value)
+{
+	this->bytes.push_back(value & 0xFF);
+	this->bytes.push_back(value >> 8);
+}
+
+void BodyDataCodec::writeUInt32(uint32_t value)
+{
+	this->writeUInt16(value & 0xFFFF);
+	this->writeUInt16(value >> 16);
+}
+
+void BodyDataCodec::writeVarint(uint32_t value)
+{
+	while (value >= 0x80) {
+		this->bytes.push_back((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	this->bytes.push_back(value);
+}
+
+void BodyDataCodec::writeSignedVarint(int value)
+{
+	// Zigzag: 0, -1, 1, -2, 2... map to 0, 1, 2, 3, 4...
+	this->writeVarint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+int BodyDataCodec::quantize(float value)
+{
+	// Joints can be mapped outside the depth frame, clamp rather than wrap around
+	float scaled = roundf(value * BodyDataCodec::COORDINATE_SCALE);
+	return (int)ofClamp(scaled, -32768, 32767);
+}
+
+float BodyDataCodec::dequantize(int value)
+{
+	return (float)value / BodyDataCodec::COORDINATE_SCALE;
+}
+
+uint16_t BodyDataCodec::readUInt16(const uint8_t* p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+uint32_t BodyDataCodec::readUInt32(const uint8_t* p)
+{
+	return (uint32_t)BodyDataCodec::readUInt16(p) | ((uint32_t)BodyDataCodec::readUInt16(p + 2) << 16);
+}
+
+bool BodyDataCodec::readVarint(const uint8_t*& p, const uint8_t* end, uint32_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 35; shift += 7) {
+		if (p >= end) return false;
+		uint8_t byte = *p++;
+		value |= (uint32_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) return true;
+	}
+	return false;
+}
+
+bool BodyDataCodec::readSignedVarint(const uint8_t*& p, const uint8_t* end, int& value)
+{
+	uint32_t zigzag;
+	if (!BodyDataCodec::readVarint(p, end, zigzag)) return false;
+	value = (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+	return true;
+}
+
+// First index from `from` on whose cell isn't value (width if there's none). Compares 16 cells at a time.
+int BodyDataCodec::findRunEnd(const uint8_t* row, int from, int width, uint8_t value)
+{
+	int x = from;
+#ifdef BODY_DATA_CODEC_SSE
+	const __m128i target = _mm_set1_epi8((char)value);
+	for (; x + 16 <= width; x += 16) {
+		int equal = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(row + x)), target));
+		if (equal == 0xFFFF) continue;
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, ~equal & 0xFFFF);
+		return x + (int)index;
+#else
+		return x + __builtin_ctz(~equal & 0xFFFF);
+#endif
+	}
+#endif
+	for (; x < width; x++) {
+		if (row[x] != value) return x;
+	}
+	return width;
+}
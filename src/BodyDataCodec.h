@@ -0,0 +1,166 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxKinectForWindows2.h"
+#include "ContourBuffer.h"
+#include "ContourAligner.h"
+#include "Constants.h"
+
+#ifndef BODY_DATA_CODEC_H
+#define BODY_DATA_CODEC_H
+
+using namespace std;
+
+// Everything the peer needs to rebuild one of our bodies
+struct BodyFrame {
+	int index;
+	bool isRecording;
+	int instrumentId;
+
+	// Set by the codec, counts up for every message of the body
+	uint32_t sequence;
+	// Sender's ofGetSystemTimeMillis() when the data was captured
+	uint32_t captureTime;
+
+	// Played out by the jitter buffer between two received frames, already smooth
+	bool isInterpolated;
+
+	// Bit i is set when joints[i] holds the position of JointType i
+	uint32_t jointMask;
+	ofVec2f joints[JointType_Count];
+
+	ContourBuffer contour;
+
+	// Silhouette sent instead of the contour: maskWidth x maskHeight cells (1 for the body) of
+	// maskScale x maskScale depth pixels each, starting at depth pixel (maskX, maskY)
+	bool hasMask;
+	int maskX, maskY;
+	int maskWidth, maskHeight;
+	int maskScale;
+	vector<uint8_t> mask;
+
+	BodyFrame();
+	void clear();
+	void setJoint(JointType joint, ofVec2f position);
+	bool hasJoint(int joint) const;
+	// Crops the body's pixels out of the body index frame, to the bounding box of the contour already in the frame.
+	// The contour is dropped: the receiver traces it back from the mask.
+	void setMask(const ofPixels& bodyIndexPixels, unsigned char label, int scale);
+};
+
+// Binary encoding of a BodyFrame, sent to the peer as a single OSC blob.
+// Fixed size fields are little endian, varints are LEB128 with zigzag for signed values.
+//
+//   uint8   MAGIC
+//   uint8   VERSION
+//   uint8   flags (bit 0: isRecording, bit 1: delta frame, bit 2: mask instead of contour)
+//   uint8   body index
+//   int8    instrument id
+//   uint8   keyframe id
+//   uint32  sequence number
+//   uint32  capture time
+//   uint32  joint mask
+//   int16   x, y for every joint in the mask, lowest JointType first
+//   varint  number of contour points
+//   keyframe: zigzag x, y of every point, relative to the previous point
+//   delta:    varint offset k, then for every point (i + k) % n which moved away from keyframe point i:
+//             varint number of unchanged points skipped before it, zigzag x, y relative to keyframe point i
+//             (a trailing skip covers the unchanged points at the end)
+//
+// Mask frames replace everything from the contour point count on with
+//   uint16  maskX, maskY
+//   uint8   maskScale
+//   uint16  maskWidth, maskHeight
+//   every row: varint number of body runs, then varint gap since the previous run and varint length of each
+// Mask frames don't touch the keyframe state.
+//
+// Coordinates are in depth space, quantized to 1 / COORDINATE_SCALE of a pixel.
+// A keyframe is sent every keyframeInterval frames of a body, the frames in between carry the
+// contour as a delta against that keyframe. The delta is taken at the rotation that best matches the
+// keyframe, so a contour whose start point moved doesn't turn into large deltas. A delta which would be
+// larger than the keyframe it refers to (fast movement) is sent as a new keyframe instead.
+// Since deltas only depend on the keyframe, losing one doesn't affect the next. After losing a keyframe
+// the receiver drops deltas until the next one comes in.
+//
+// One codec instance keeps the per-body state for one direction of one peer link.
+class BodyDataCodec {
+public:
+	static const uint8_t MAGIC = 0xB0;
+	static const uint8_t VERSION = 4;
+	static const int COORDINATE_SCALE = 8;
+	static const int HEADER_SIZE = 18;
+
+	BodyDataCodec();
+
+	void setKeyframeInterval(int keyframeInterval);
+
+	// Returns the number of bytes written to buffer
+	int encode(const BodyFrame& frame, ofBuffer& buffer);
+	// False (and frame left untouched) if the message is truncated, malformed, from another version,
+	// or a delta against a keyframe we never received
+	bool decode(const ofBuffer& buffer, BodyFrame& frame);
+	// Reads only the body index and sequence number, to drop stale messages before decoding them
+	static bool peekSequence(const ofBuffer& buffer, int& index, uint32_t& sequence);
+
+	int getEncodedBytes();
+	int getKeyframeCount();
+	int getDeltaCount();
+	int getDecodeErrors();
+	int getMissingKeyframes();
+
+private:
+	struct KeyframeState {
+		uint8_t id;
+		int age;
+		int size;
+		bool valid;
+		vector<int> x;
+		vector<int> y;
+		KeyframeState() : id(0), age(0), size(0), valid(false) {}
+	};
+
+	map<int, KeyframeState> encoderState;
+	map<int, KeyframeState> decoderState;
+	map<int, uint32_t> sequences;
+	ContourAligner aligner;
+	ContourBuffer keyframeContour;
+
+	int keyframeInterval;
+	vector<uint8_t> bytes;
+	vector<int> quantizedX;
+	vector<int> quantizedY;
+	vector<int> decodedX;
+	vector<int> decodedY;
+
+	int encodedBytes;
+	int keyframeCount;
+	int deltaCount;
+	int decodeErrors;
+	int missingKeyframes;
+
+	vector<uint8_t> decodedMask;
+	// Start / end pairs of the body runs on the mask row being encoded
+	vector<int> rowRuns;
+
+	void writeHeader(const BodyFrame& frame, bool isDelta, uint8_t keyframeId, uint32_t sequence);
+	void writeKeyframeContour();
+	void writeDeltaContour(const KeyframeState& keyframe, int offset);
+	void writeMask(const BodyFrame& frame);
+	bool readMask(const uint8_t*& p, const uint8_t* end, int& maskX, int& maskY, int& maskScale, int& maskWidth, int& maskHeight);
+
+	void writeUInt8(uint8_t value);
+	void writeUInt16(uint16_t value);
+	void writeUInt32(uint32_t value);
+	void writeVarint(uint32_t value);
+	void writeSignedVarint(int value);
+
+	static int quantize(float value);
+	static float dequantize(int value);
+	static uint16_t readUInt16(const uint8_t* p);
+	static uint32_t readUInt32(const uint8_t* p);
+	static bool readVarint(const uint8_t*& p, const uint8_t* end, uint32_t& value);
+	static bool readSignedVarint(const uint8_t*& p, const uint8_t* end, int& value);
+	static int findRunEnd(const uint8_t* row, int from, int width, uint8_t value);
+};
+
+#endif
@@ -0,0 +1,216 @@
+#include "BodyJitterBuffer.h"
+
+BodyJitterBuffer::BodyJitterBuffer()
+{
+	this->entries.resize(CAPACITY);
+	this->clear();
+}
+
+void BodyJitterBuffer::clear()
+{
+	this->count = 0;
+	this->lastCaptureTime = 0;
+	this->transitCount = 0;
+	this->baseTransit = 0;
+	this->jitter = 0;
+	this->sendInterval = 0;
+	this->playoutDelay = 0;
+	this->playoutTime = 0;
+	this->previousTransit = 0;
+	this->lateFrames = 0;
+	this->pairSequences[0] = this->pairSequences[1] = 0;
+	this->pairContours[0].clear();
+	this->pairContours[1].clear();
+	this->pairOffset = 0;
+	this->lastSampleTime = -1;
+	this->lastSampleSequence = 0;
+}
+
+void BodyJitterBuffer::push(BodyFrame& frame, uint64_t arrivalTime)
+{
+	// Unwrap the sender's 32 bit millisecond clock
+	int64_t captureTime = frame.captureTime;
+	if (this->transitCount > 0) {
+		captureTime = this->lastCaptureTime + (int32_t)(frame.captureTime - (uint32_t)this->lastCaptureTime);
+		if (captureTime > this->lastCaptureTime) {
+			float interval = captureTime - this->lastCaptureTime;
+			this->sendInterval = (this->sendInterval == 0) ? interval : 0.9 * this->sendInterval + 0.1 * interval;
+		}
+	}
+	this->lastCaptureTime = max(this->lastCaptureTime, captureTime);
+
+	// The smallest recent transit time stands for clock offset + network delay, everything above it is jitter
+	int64_t transit = (int64_t)arrivalTime - captureTime;
+	if (this->transitCount > 0) {
+		this->jitter += (fabs((float)(transit - this->previousTransit)) - this->jitter) / 16;
+	}
+	this->previousTransit = transit;
+	this->transits[this->transitCount % (CAPACITY * 4)] = transit;
+	this->transitCount++;
+	this->baseTransit = transit;
+	for (int i = 0; i < min(this->transitCount, CAPACITY * 4); i++) {
+		this->baseTransit = min(this->baseTransit, this->transits[i]);
+	}
+
+	if (this->lastSampleTime >= 0 && captureTime < this->playoutTime) this->lateFrames++;
+
+	// Drop the oldest frame when full
+	if (this->count == CAPACITY) {
+		for (int i = 0; i < this->count - 1; i++) swap(this->entries[i], this->entries[i + 1]);
+		this->count--;
+	}
+
+	// Insert ordered by capture time
+	int position = this->count;
+	swap(this->entries[position].frame, frame);
+	this->entries[position].captureTime = captureTime;
+	this->count++;
+	while (position > 0 && this->entries[position - 1].captureTime > captureTime) {
+		swap(this->entries[position], this->entries[position - 1]);
+		position--;
+	}
+}
+
+bool BodyJitterBuffer::sample(uint64_t now, BodyFrame& output)
+{
+	if (this->count == 0) return false;
+
+	// Enough delay to have the next frame in by the time it's needed, most of the time
+	float targetDelay = ofClamp(this->sendInterval + 3 * this->jitter, 0, Constants::JITTER_MAX_PLAYOUT_DELAY_MS);
+	this->playoutDelay += (targetDelay - this->playoutDelay) * 0.05;
+
+	// Playout time, on the sender's clock. It never goes backwards, a growing delay holds it for a while instead
+	int64_t time = (int64_t)now - this->baseTransit - (int64_t)this->playoutDelay;
+	if (this->lastSampleTime >= 0) time = max(time, this->playoutTime);
+	this->playoutTime = time;
+
+	// Newest frame at or before the playout time, everything older than the one before it isn't needed anymore
+	int current = -1;
+	while (current + 1 < this->count && this->entries[current + 1].captureTime <= time) current++;
+	while (current >= 2) {
+		for (int i = 0; i < this->count - 1; i++) swap(this->entries[i], this->entries[i + 1]);
+		this->count--;
+		current--;
+	}
+
+	int64_t sampleTime;
+	uint32_t sampleSequence;
+	if (current < 0) {
+		// Still before the first frame
+		sampleTime = this->entries[0].captureTime;
+		sampleSequence = this->entries[0].frame.sequence;
+		if (sampleTime == this->lastSampleTime && sampleSequence == this->lastSampleSequence) return false;
+		output = this->entries[0].frame;
+	}
+	else if (current + 1 < this->count) {
+		const Entry& first = this->entries[current];
+		const Entry& second = this->entries[current + 1];
+		sampleTime = time;
+		sampleSequence = first.frame.sequence;
+		if (sampleTime == this->lastSampleTime && sampleSequence == this->lastSampleSequence) return false;
+		float span = second.captureTime - first.captureTime;
+		this->interpolate(first, second, (span > 0) ? (time - first.captureTime) / span : 1, output);
+	}
+	else if (current >= 1) {
+		// Late: keep going the way the last two frames went, for a little while
+		const Entry& first = this->entries[current - 1];
+		const Entry& second = this->entries[current];
+		sampleTime = min(time, second.captureTime + Constants::JITTER_MAX_EXTRAPOLATION_MS);
+		sampleSequence = second.frame.sequence;
+		if (sampleTime == this->lastSampleTime && sampleSequence == this->lastSampleSequence) return false;
+		float span = second.captureTime - first.captureTime;
+		this->interpolate(first, second, (span > 0) ? (sampleTime - first.captureTime) / span : 1, output);
+	}
+	else {
+		sampleTime = this->entries[current].captureTime;
+		sampleSequence = this->entries[current].frame.sequence;
+		if (sampleTime == this->lastSampleTime && sampleSequence == this->lastSampleSequence) return false;
+		output = this->entries[current].frame;
+	}
+
+	this->lastSampleTime = sampleTime;
+	this->lastSampleSequence = sampleSequence;
+	return true;
+}
+
+bool BodyJitterBuffer::isEmpty()
+{
+	return this->count == 0;
+}
+
+float BodyJitterBuffer::getPlayoutDelay()
+{
+	return this->playoutDelay;
+}
+
+float BodyJitterBuffer::getJitter()
+{
+	return this->jitter;
+}
+
+int BodyJitterBuffer::getLateFrames()
+{
+	return this->lateFrames;
+}
+
+void BodyJitterBuffer::preparePair(const Entry& first, const Entry& second)
+{
+	if (this->pairSequences[0] == first.frame.sequence && this->pairSequences[1] == second.frame.sequence) return;
+	this->pairSequences[0] = first.frame.sequence;
+	this->pairSequences[1] = second.frame.sequence;
+
+	// Same number of points on both, second rotated to match the first
+	int noPoints = min(max(first.frame.contour.size(), second.frame.contour.size()), Constants::MAX_CONTOUR_POINTS);
+	if (first.frame.contour.size() == 0 || second.frame.contour.size() == 0) noPoints = 0;
+
+	this->resampler.setSource(first.frame.contour);
+	this->resampler.resample(noPoints, this->pairContours[0]);
+	this->resampler.setSource(second.frame.contour);
+	this->resampler.resample(noPoints, this->pairContours[1]);
+	this->pairOffset = (noPoints > 0) ? this->aligner.findBestOffset(this->pairContours[0], this->pairContours[1]) : 0;
+}
+
+void BodyJitterBuffer::interpolate(const Entry& first, const Entry& second, float alpha, BodyFrame& output)
+{
+	this->preparePair(first, second);
+
+	const BodyFrame& latest = (alpha < 1) ? first.frame : second.frame;
+	output.index = latest.index;
+	output.isRecording = latest.isRecording;
+	output.instrumentId = latest.instrumentId;
+	output.sequence = latest.sequence;
+	output.captureTime = first.frame.captureTime + (uint32_t)(alpha * (second.captureTime - first.captureTime));
+	output.hasMask = false;
+	output.isInterpolated = true;
+
+	output.jointMask = first.frame.jointMask | second.frame.jointMask;
+	for (int joint = 0; joint < JointType_Count; joint++) {
+		bool inFirst = first.frame.hasJoint(joint);
+		bool inSecond = second.frame.hasJoint(joint);
+		if (inFirst && inSecond) {
+			output.joints[joint] = first.frame.joints[joint] + (second.frame.joints[joint] - first.frame.joints[joint]) * alpha;
+		}
+		else if (inFirst || inSecond) {
+			output.joints[joint] = inFirst ? first.frame.joints[joint] : second.frame.joints[joint];
+		}
+	}
+
+	const int noPoints = this->pairContours[0].size();
+	if (noPoints == 0) {
+		output.contour = latest.contour;
+		return;
+	}
+
+	output.contour.resize(noPoints);
+	const float* firstX = this->pairContours[0].getX();
+	const float* firstY = this->pairContours[0].getY();
+	const float* secondX = this->pairContours[1].getX();
+	const float* secondY = this->pairContours[1].getY();
+	float* x = output.contour.getX();
+	float* y = output.contour.getY();
+	for (int i = 0; i < noPoints; i++) {
+		int k = (i + this->pairOffset) % noPoints;
+		x[i] = firstX[i] + (secondX[k] - firstX[i]) * alpha;
+		y[i] = firstY[i] + (secondY[k] - firstY[i]) * alpha;
+	}
+}
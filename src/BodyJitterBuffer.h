@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+#include "ofMain.h"
+#include "Constants.h"
+#include "BodyDataCodec.h"
+#include "ContourAligner.h"
+#include "ContourResampler.h"
+
+#ifndef BODY_JITTER_BUFFER_H
+#define BODY_JITTER_BUFFER_H
+
+using namespace std;
+
+// Plays a remote body back smoothly from the frames the peer sends every few frames.
+// Frames are kept ordered by capture time and played out a little behind the sender's clock:
+// the playout delay adapts to the send interval and to the jitter of the transit times (RFC 3550 style).
+// Between two frames, joints and contours are interpolated (contours are resampled to the same
+// number of points and aligned first). Past the newest frame the last movement is extrapolated,
+// for at most JITTER_MAX_EXTRAPOLATION_MS, then the body holds still until the next frame comes in.
+class BodyJitterBuffer {
+public:
+	BodyJitterBuffer();
+	void clear();
+
+	// Takes the frame's contents, frame gets a recycled frame back. Times are local ofGetSystemTimeMillis()
+	void push(BodyFrame& frame, uint64_t arrivalTime);
+	// Frame at the current playout time. False if there's nothing to play or it didn't change since the last call
+	bool sample(uint64_t now, BodyFrame& output);
+
+	bool isEmpty();
+	float getPlayoutDelay();
+	float getJitter();
+	int getLateFrames();
+
+	static const int CAPACITY = 16;
+
+private:
+	struct Entry {
+		BodyFrame frame;
+		int64_t captureTime;
+	};
+
+	// Oldest first
+	vector<Entry> entries;
+	int count;
+
+	// Sender clock (unwrapped) to local clock
+	int64_t lastCaptureTime;
+	int64_t transits[CAPACITY * 4];
+	int transitCount;
+	int64_t baseTransit;
+
+	float jitter;
+	float sendInterval;
+	float playoutDelay;
+	int64_t playoutTime;
+	int64_t previousTransit;
+	int lateFrames;
+
+	// Interpolation pair and the time last played out of it
+	uint32_t pairSequences[2];
+	ContourBuffer pairContours[2];
+	int pairOffset;
+	int64_t lastSampleTime;
+	uint32_t lastSampleSequence;
+
+	ContourAligner aligner;
+	ContourResampler resampler;
+
+	void preparePair(const Entry& first, const Entry& second);
+	void interpolate(const Entry& first, const Entry& second, float alpha, BodyFrame& output);
+};
+
+#endif
@@ -0,0 +1,341 @@
+#include "BodyMask.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BODY_MASK_SSE
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static inline int popcount64(uint64_t word)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	return (int)__popcnt64(word);
+#elif defined(__GNUC__)
+	return __builtin_popcountll(word);
+#else
+	word = word - ((word >> 1) & 0x5555555555555555ULL);
+	word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+	word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Index of the lowest / highest set bit, word must not be 0
+static inline int lowestBit(uint64_t word)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return (int)index;
+#elif defined(__GNUC__)
+	return __builtin_ctzll(word);
+#else
+	int index = 0;
+	while (!(word & 1)) { word >>= 1; index++; }
+	return index;
+#endif
+}
+
+static inline int highestBit(uint64_t word)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, word);
+	return (int)index;
+#elif defined(__GNUC__)
+	return 63 - __builtin_clzll(word);
+#else
+	int index = 0;
+	while (word >>= 1) index++;
+	return index;
+#endif
+}
+
+BodyMask::BodyMask()
+{
+	this->words.assign(HEIGHT * WORDS_PER_ROW, 0);
+	this->rowCrossings.resize(HEIGHT);
+	this->area = 0;
+	this->minX = WIDTH;
+	this->maxX = -1;
+	this->minY = HEIGHT;
+	this->maxY = -1;
+}
+
+void BodyMask::clear()
+{
+	// Only the rows inside the bounding box can have bits set
+	if (this->minY <= this->maxY) {
+		fill(this->words.begin() + this->minY * WORDS_PER_ROW, this->words.begin() + (this->maxY + 1) * WORDS_PER_ROW, 0);
+	}
+	this->area = 0;
+	this->minX = WIDTH;
+	this->maxX = -1;
+	this->minY = HEIGHT;
+	this->maxY = -1;
+}
+
+// Even-odd scanline fill, sampling every pixel at its center
+void BodyMask::rasterize(const ContourBuffer& contour)
+{
+	this->clear();
+
+	const int n = contour.size();
+	if (n < 3) return;
+
+	const float* xs = contour.getX();
+	const float* ys = contour.getY();
+
+	int firstRow = HEIGHT, lastRow = -1;
+	for (int i = 0; i < n; i++) {
+		const int j = (i + 1 == n) ? 0 : i + 1;
+		const float x0 = xs[i], y0 = ys[i];
+		const float x1 = xs[j], y1 = ys[j];
+		if (y0 == y1) continue;
+
+		// Rows whose center lies in [min(y0, y1), max(y0, y1))
+		int rowStart = (int)ceil(min(y0, y1) - 0.5f);
+		int rowEnd = (int)ceil(max(y0, y1) - 0.5f) - 1;
+		rowStart = max(rowStart, 0);
+		rowEnd = min(rowEnd, HEIGHT - 1);
+		if (rowStart > rowEnd) continue;
+
+		const float slope = (x1 - x0) / (y1 - y0);
+		for (int row = rowStart; row <= rowEnd; row++) {
+			this->rowCrossings[row].push_back(x0 + (row + 0.5f - y0) * slope);
+		}
+
+		firstRow = min(firstRow, rowStart);
+		lastRow = max(lastRow, rowEnd);
+	}
+
+	for (int row = firstRow; row <= lastRow; row++) {
+		vector<float>& crossings = this->rowCrossings[row];
+		sort(crossings.begin(), crossings.end());
+
+		for (int i = 0; i + 1 < crossings.size(); i += 2) {
+			int start = max((int)ceil(crossings[i] - 0.5f), 0);
+			int end = min((int)ceil(crossings[i + 1] - 0.5f) - 1, WIDTH - 1);
+			if (start > end) continue;
+
+			this->setSpan(row, start, end);
+			this->area += end - start + 1;
+			this->minX = min(this->minX, start);
+			this->maxX = max(this->maxX, end);
+			this->minY = min(this->minY, row);
+			this->maxY = max(this->maxY, row);
+		}
+
+		crossings.clear();
+	}
+}
+
+void BodyMask::setSpan(int row, int start, int end)
+{
+	uint64_t* rowWords = &this->words[row * WORDS_PER_ROW];
+	const int startWord = start >> 6;
+	const int endWord = end >> 6;
+	const uint64_t startMask = ~0ULL << (start & 63);
+	const uint64_t endMask = ~0ULL >> (63 - (end & 63));
+
+	if (startWord == endWord) {
+		rowWords[startWord] |= startMask & endMask;
+		return;
+	}
+
+	rowWords[startWord] |= startMask;
+	for (int i = startWord + 1; i < endWord; i++) rowWords[i] = ~0ULL;
+	rowWords[endWord] |= endMask;
+}
+
+// this = a AND b. Returns the number of pixels in the intersection.
+int BodyMask::intersect(const BodyMask& a, const BodyMask& b)
+{
+	this->clear();
+	if (!a.boundingBoxOverlaps(b)) return 0;
+
+	const int rowStart = max(a.minY, b.minY);
+	const int rowEnd = min(a.maxY, b.maxY);
+	const int wordStart = max(a.minX, b.minX) >> 6;
+	const int wordEnd = min(a.maxX, b.maxX) >> 6;
+
+	for (int row = rowStart; row <= rowEnd; row++) {
+		const uint64_t* aWords = &a.words[row * WORDS_PER_ROW];
+		const uint64_t* bWords = &b.words[row * WORDS_PER_ROW];
+		uint64_t* resultWords = &this->words[row * WORDS_PER_ROW];
+
+		int rowArea = 0;
+		int w = wordStart;
+#ifdef BODY_MASK_SSE
+		for (; w + 1 <= wordEnd; w += 2) {
+			__m128i both = _mm_and_si128(_mm_loadu_si128((const __m128i*)(aWords + w)), _mm_loadu_si128((const __m128i*)(bWords + w)));
+			_mm_storeu_si128((__m128i*)(resultWords + w), both);
+		}
+#endif
+		for (; w <= wordEnd; w++) {
+			resultWords[w] = aWords[w] & bWords[w];
+		}
+
+		for (w = wordStart; w <= wordEnd; w++) {
+			const uint64_t word = resultWords[w];
+			if (word == 0) continue;
+			rowArea += popcount64(word);
+			this->minX = min(this->minX, (w << 6) + lowestBit(word));
+			this->maxX = max(this->maxX, (w << 6) + highestBit(word));
+		}
+
+		if (rowArea > 0) {
+			this->area += rowArea;
+			this->minY = min(this->minY, row);
+			this->maxY = max(this->maxY, row);
+		}
+	}
+
+	return this->area;
+}
+
+bool BodyMask::isEmpty() const
+{
+	return this->area == 0;
+}
+
+int BodyMask::getArea() const
+{
+	return this->area;
+}
+
+bool BodyMask::get(int x, int y) const
+{
+	if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) return false;
+	return (this->words[y * WORDS_PER_ROW + (x >> 6)] >> (x & 63)) & 1;
+}
+
+const uint64_t* BodyMask::getRow(int y) const
+{
+	return &this->words[y * WORDS_PER_ROW];
+}
+
+bool BodyMask::boundingBoxOverlaps(const BodyMask& other) const
+{
+	if (this->isEmpty() || other.isEmpty()) return false;
+	return this->minX <= other.maxX && other.minX <= this->maxX &&
+		this->minY <= other.maxY && other.minY <= this->maxY;
+}
+
+int BodyMask::getMinX() const
+{
+	return this->minX;
+}
+
+int BodyMask::getMaxX() const
+{
+	return this->maxX;
+}
+
+int BodyMask::getMinY() const
+{
+	return this->minY;
+}
+
+int BodyMask::getMaxY() const
+{
+	return this->maxY;
+}
+
+// First position >= from whose bit equals value, or WIDTH if there is none
+int BodyMask::findNextBit(const uint64_t* row, int from, bool value) const
+{
+	int w = from >> 6;
+	if (w >= WORDS_PER_ROW) return WIDTH;
+
+	uint64_t word = (value ? row[w] : ~row[w]) & (~0ULL << (from & 63));
+	while (word == 0) {
+		if (++w >= WORDS_PER_ROW) return WIDTH;
+		word = value ? row[w] : ~row[w];
+	}
+	return min((w << 6) + lowestBit(word), WIDTH);
+}
+
+int BodyMask::findComponent(int id)
+{
+	while (this->componentParents[id] != id) {
+		this->componentParents[id] = this->componentParents[this->componentParents[id]];
+		id = this->componentParents[id];
+	}
+	return id;
+}
+
+// Number of 8-connected regions, found by merging runs of set pixels with the runs on the row above
+int BodyMask::countComponents()
+{
+	if (this->isEmpty()) return 0;
+
+	this->componentParents.clear();
+	this->previousRuns.clear();
+	this->previousRunIds.clear();
+	int components = 0;
+
+	for (int row = this->minY; row <= this->maxY; row++) {
+		const uint64_t* rowWords = &this->words[row * WORDS_PER_ROW];
+		this->currentRuns.clear();
+		this->currentRunIds.clear();
+
+		int p = 0;
+		int x = this->findNextBit(rowWords, this->minX, true);
+		while (x <= this->maxX) {
+			int end = this->findNextBit(rowWords, x, false) - 1;
+
+			int id = this->componentParents.size();
+			this->componentParents.push_back(id);
+			components++;
+
+			// Previous runs are sorted, skip the ones entirely to the left of this run
+			while (p < this->previousRuns.size() && this->previousRuns[p].second < x - 1) p++;
+			for (int q = p; q < this->previousRuns.size() && this->previousRuns[q].first <= end + 1; q++) {
+				int root = this->findComponent(this->previousRunIds[q]);
+				int current = this->findComponent(id);
+				if (root != current) {
+					this->componentParents[root] = current;
+					components--;
+				}
+			}
+
+			this->currentRuns.push_back(make_pair(x, end));
+			this->currentRunIds.push_back(id);
+			x = this->findNextBit(rowWords, end + 1, true);
+		}
+
+		swap(this->previousRuns, this->currentRuns);
+		swap(this->previousRunIds, this->currentRunIds);
+	}
+
+	return components;
+}
+
+// RGBA pixels, color where the mask is set and fully transparent elsewhere
+void BodyMask::toPixels(ofPixels& pixels, ofColor color) const
+{
+	if (pixels.getWidth() != WIDTH || pixels.getHeight() != HEIGHT || pixels.getNumChannels() != 4) {
+		pixels.allocate(WIDTH, HEIGHT, OF_PIXELS_RGBA);
+	}
+	pixels.set(0);
+
+	for (int row = this->minY; row <= this->maxY; row++) {
+		const uint64_t* rowWords = &this->words[row * WORDS_PER_ROW];
+		unsigned char* rowPixels = pixels.getData() + row * WIDTH * 4;
+		for (int w = 0; w < WORDS_PER_ROW; w++) {
+			uint64_t word = rowWords[w];
+			while (word != 0) {
+				int x = (w << 6) + lowestBit(word);
+				word &= word - 1;
+				rowPixels[4 * x] = color.r;
+				rowPixels[4 * x + 1] = color.g;
+				rowPixels[4 * x + 2] = color.b;
+				rowPixels[4 * x + 3] = color.a;
+			}
+		}
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include "ofMain.h"
+#include "Constants.h"
+#include "ContourBuffer.h"
+
+#ifndef BODY_MASK_H
+#define BODY_MASK_H
+
+using namespace std;
+
+// Body silhouette as a packed bitmask at depth resolution (one bit per depth pixel, 64 pixels per word).
+// Two masks intersect with a word-wise AND + popcount, restricted to the overlap of their bounding boxes.
+class BodyMask {
+public:
+	BodyMask();
+
+	void clear();
+	void rasterize(const ContourBuffer& contour);
+	int intersect(const BodyMask& a, const BodyMask& b);
+
+	bool isEmpty() const;
+	int getArea() const;
+	bool get(int x, int y) const;
+	const uint64_t* getRow(int y) const;
+	bool boundingBoxOverlaps(const BodyMask& other) const;
+	int getMinX() const;
+	int getMaxX() const;
+	int getMinY() const;
+	int getMaxY() const;
+
+	int countComponents();
+	void toPixels(ofPixels& pixels, ofColor color) const;
+
+	static const int WIDTH = Constants::DEPTH_WIDTH;
+	static const int HEIGHT = Constants::DEPTH_HEIGHT;
+	static const int WORDS_PER_ROW = (WIDTH + 63) / 64;
+
+private:
+	vector<uint64_t> words;
+	int area;
+	// Bounding box (inclusive), minX > maxX when the mask is empty
+	int minX, maxX, minY, maxY;
+
+	// Scanline fill helpers
+	vector<vector<float> > rowCrossings;
+	void setSpan(int row, int start, int end);
+
+	// Connected component helpers
+	vector<pair<int, int> > previousRuns, currentRuns;
+	vector<int> previousRunIds, currentRunIds;
+	vector<int> componentParents;
+	int findComponent(int id);
+	int findNextBit(const uint64_t* row, int from, bool value) const;
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include "BodyOverlapDetector.h"
+
+BodyOverlapDetector::BodyOverlapDetector()
+{
+	this->bodyCount = 0;
+	this->candidatePairCount = 0;
+	this->cellBodies.resize(GRID_COLUMNS * GRID_ROWS);
+}
+
+BodyOverlapDetector::~BodyOverlapDetector()
+{
+	for (int i = 0; i < this->maskPool.size(); i++) {
+		delete this->maskPool[i];
+	}
+}
+
+void BodyOverlapDetector::begin()
+{
+	this->bodyCount = 0;
+}
+
+void BodyOverlapDetector::addBody(int key, TrackedBody* body)
+{
+	if (body == NULL || body->contour.size() < 3) return;
+
+	// Entries and masks are reused from one frame to the next
+	if (this->bodyCount == this->entries.size()) {
+		BodyEntry newEntry;
+		newEntry.key = -1;
+		newEntry.body = NULL;
+		newEntry.dataFrame = 0;
+		this->entries.push_back(newEntry);
+	}
+	if (this->bodyCount == this->maskPool.size()) {
+		this->maskPool.push_back(new BodyMask());
+	}
+
+	BodyEntry& entry = this->entries[this->bodyCount];
+	entry.soundId = body->getSoundId();
+	entry.mask = this->maskPool[this->bodyCount];
+
+	// The same body in the same slot as last frame, without new data (remote bodies between two messages),
+	// still has its mask and occupancy from then
+	bool isUnchanged = entry.key == key && entry.body == body && entry.dataFrame == body->getDataFrame();
+	if (!isUnchanged) {
+		entry.key = key;
+		entry.body = body;
+		entry.dataFrame = body->getDataFrame();
+		entry.mask->rasterize(body->contour);
+		if (!entry.mask->isEmpty()) this->computeOccupancy(entry);
+	}
+	if (entry.mask->isEmpty()) return;
+
+	this->bodyCount++;
+}
+
+void BodyOverlapDetector::computeOccupancy(BodyEntry& entry)
+{
+	for (int i = 0; i < GRID_WORDS; i++) entry.occupancy[i] = 0;
+
+	const BodyMask* mask = entry.mask;
+	const int wordStart = mask->getMinX() >> 6;
+	const int wordEnd = mask->getMaxX() >> 6;
+
+	for (int y = mask->getMinY(); y <= mask->getMaxY(); y++) {
+		const uint64_t* row = mask->getRow(y);
+		const int cellRow = (y / CELL_SIZE) * GRID_COLUMNS;
+		for (int w = wordStart; w <= wordEnd; w++) {
+			if (row[w] & 0xFFFFFFFFULL) {
+				const int cell = cellRow + 2 * w;
+				entry.occupancy[cell >> 6] |= 1ULL << (cell & 63);
+			}
+			if (row[w] >> 32) {
+				const int cell = cellRow + 2 * w + 1;
+				entry.occupancy[cell >> 6] |= 1ULL << (cell & 63);
+			}
+		}
+	}
+}
+
+void BodyOverlapDetector::detect()
+{
+	this->overlaps.clear();
+	this->endedOverlaps.clear();
+	this->candidatePairCount = 0;
+
+	for (auto it = this->activeOverlaps.begin(); it != this->activeOverlaps.end(); ++it) {
+		it->second.seen = false;
+	}
+
+	// Bucket bodies by occupied grid cell
+	for (int i = 0; i < this->bodyCount; i++) {
+		const BodyEntry& entry = this->entries[i];
+		for (int cell = 0; cell < this->cellBodies.size(); cell++) {
+			if ((entry.occupancy[cell >> 6] >> (cell & 63)) & 1) this->cellBodies[cell].push_back(i);
+		}
+	}
+
+	// Bodies sharing a cell are candidates, each pair is tested once
+	this->testedPairs.assign(this->bodyCount * this->bodyCount, 0);
+	for (int cell = 0; cell < this->cellBodies.size(); cell++) {
+		vector<int>& bodies = this->cellBodies[cell];
+		for (int a = 0; a < bodies.size(); a++) {
+			for (int b = a + 1; b < bodies.size(); b++) {
+				const int pairIndex = bodies[a] * this->bodyCount + bodies[b];
+				if (this->testedPairs[pairIndex]) continue;
+				this->testedPairs[pairIndex] = 1;
+				this->candidatePairCount++;
+				this->testPair(this->entries[bodies[a]], this->entries[bodies[b]]);
+			}
+		}
+		bodies.clear();
+	}
+
+	// Overlaps that disappeared this frame
+	for (auto it = this->activeOverlaps.begin(); it != this->activeOverlaps.end(); ) {
+		if (it->second.seen) {
+			++it;
+			continue;
+		}
+
+		BodyOverlap ended;
+		ended.firstKey = it->first.first;
+		ended.secondKey = it->first.second;
+		ended.firstSoundId = it->second.firstSoundId;
+		ended.secondSoundId = it->second.secondSoundId;
+		ended.normalizedArea = 0;
+		ended.noPolys = 0;
+		ended.duration = 0;
+		this->endedOverlaps.push_back(ended);
+		it = this->activeOverlaps.erase(it);
+	}
+}
+
+void BodyOverlapDetector::testPair(const BodyEntry& first, const BodyEntry& second)
+{
+	int area = this->intersectionMask.intersect(*first.mask, *second.mask);
+	if (area == 0) return;
+
+	const bool swapped = first.key > second.key;
+	const BodyEntry& lower = swapped ? second : first;
+	const BodyEntry& upper = swapped ? first : second;
+	const pair<int, int> key = make_pair(lower.key, upper.key);
+
+	auto active = this->activeOverlaps.find(key);
+	if (active == this->activeOverlaps.end()) {
+		ActiveOverlap started;
+		started.startTimestamp = ofGetSystemTimeMillis();
+		active = this->activeOverlaps.insert(make_pair(key, started)).first;
+	}
+	active->second.firstSoundId = lower.soundId;
+	active->second.secondSoundId = upper.soundId;
+	active->second.seen = true;
+
+	BodyOverlap overlap;
+	overlap.firstKey = lower.key;
+	overlap.secondKey = upper.key;
+	overlap.firstSoundId = lower.soundId;
+	overlap.secondSoundId = upper.soundId;
+	overlap.normalizedArea = 1.0 * area / min(first.mask->getArea(), second.mask->getArea());
+	overlap.noPolys = this->intersectionMask.countComponents();
+	overlap.duration = (1.0 * ofGetSystemTimeMillis() - active->second.startTimestamp) / 1000.0;
+	this->overlaps.push_back(overlap);
+}
+
+const vector<BodyOverlap>& BodyOverlapDetector::getOverlaps()
+{
+	return this->overlaps;
+}
+
+const vector<BodyOverlap>& BodyOverlapDetector::getEndedOverlaps()
+{
+	return this->endedOverlaps;
+}
+
+int BodyOverlapDetector::getBodyCount()
+{
+	return this->bodyCount;
+}
+
+int BodyOverlapDetector::getCandidatePairCount()
+{
+	return this->candidatePairCount;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdint.h>
+#include "ofMain.h"
+#include "Constants.h"
+#include "BodyMask.h"
+#include "TrackedBody.h"
+
+#ifndef BODY_OVERLAP_DETECTOR_H
+#define BODY_OVERLAP_DETECTOR_H
+
+using namespace std;
+
+struct BodyOverlap {
+	int firstKey;
+	int secondKey;
+	int firstSoundId;
+	int secondSoundId;
+	float normalizedArea;
+	int noPolys;
+	float duration;
+};
+
+// Finds every overlapping pair among all active bodies (local, remote and shadows).
+// Each body gets a bitmask with its bounding box, plus a coarse occupancy grid. Only bodies sharing
+// an occupied grid cell become candidate pairs, and only candidates get the exact bitmask intersection.
+class BodyOverlapDetector {
+public:
+	BodyOverlapDetector();
+	~BodyOverlapDetector();
+
+	// Per frame: begin(), addBody() for every active body, then detect().
+	// Keys identify a body on every site: site * SITE_BODY_IDS + body index (Kinect id or shadow index)
+	void begin();
+	void addBody(int key, TrackedBody* body);
+	void detect();
+
+	const vector<BodyOverlap>& getOverlaps();
+	// Pairs which overlapped on the previous frame and don't anymore
+	const vector<BodyOverlap>& getEndedOverlaps();
+
+	int getBodyCount();
+	int getCandidatePairCount();
+
+	// Half a mask word per cell, so occupancy comes straight from the mask words
+	static const int CELL_SIZE = 32;
+	static const int GRID_COLUMNS = (Constants::DEPTH_WIDTH + CELL_SIZE - 1) / CELL_SIZE;
+	static const int GRID_ROWS = (Constants::DEPTH_HEIGHT + CELL_SIZE - 1) / CELL_SIZE;
+	static const int GRID_WORDS = (GRID_COLUMNS * GRID_ROWS + 63) / 64;
+
+private:
+	struct BodyEntry {
+		int key;
+		int soundId;
+		// Body & data frame the mask was rasterized from
+		TrackedBody* body;
+		uint64_t dataFrame;
+		BodyMask* mask;
+		uint64_t occupancy[GRID_WORDS];
+	};
+
+	struct ActiveOverlap {
+		float startTimestamp;
+		int firstSoundId;
+		int secondSoundId;
+		bool seen;
+	};
+
+	vector<BodyEntry> entries;
+	int bodyCount;
+	vector<BodyMask*> maskPool;
+
+	vector<vector<int> > cellBodies;
+	vector<char> testedPairs;
+	int candidatePairCount;
+
+	BodyMask intersectionMask;
+	vector<BodyOverlap> overlaps;
+	vector<BodyOverlap> endedOverlaps;
+	map<pair<int, int>, ActiveOverlap> activeOverlaps;
+
+	void computeOccupancy(BodyEntry& entry);
+	void testPair(const BodyEntry& first, const BodyEntry& second);
+};
+
+#endif
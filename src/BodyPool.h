@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ofMain.h"
+
+#ifndef BODY_POOL_H
+#define BODY_POOL_H
+
+using namespace std;
+
+// Fixed capacity pool of pre-built bodies, filled once at start-up.
+// acquire() hands out a body reset in place for its new index, release() resets it again
+// (dropping its instrument, GPU resources and per-visitor data) and puts it back.
+// Nothing is allocated or freed while people come and go.
+template <typename T>
+class BodyPool {
+public:
+	BodyPool() {
+		this->liveCount = 0;
+		this->peakCount = 0;
+	}
+
+	~BodyPool() {
+		for (int i = 0; i < this->bodies.size(); i++) {
+			delete this->bodies[i];
+		}
+	}
+
+	void add(T* body) {
+		this->bodies.push_back(body);
+		this->freeBodies.push_back(body);
+	}
+
+	// NULL when every body is in use
+	T* acquire(int index) {
+		if (this->freeBodies.size() == 0) return NULL;
+
+		T* body = this->freeBodies.back();
+		this->freeBodies.pop_back();
+		body->reset(index);
+
+		this->liveCount++;
+		this->peakCount = max(this->peakCount, this->liveCount);
+		return body;
+	}
+
+	void release(T* body) {
+		if (body == NULL) return;
+		body->reset(body->index);
+		this->freeBodies.push_back(body);
+		this->liveCount--;
+	}
+
+	int getCapacity() { return this->bodies.size(); }
+	int getLiveCount() { return this->liveCount; }
+	int getPeakCount() { return this->peakCount; }
+
+private:
+	vector<T*> bodies;
+	vector<T*> freeBodies;
+	int liveCount;
+	int peakCount;
+};
+
+#endif
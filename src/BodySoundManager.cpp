@@ -10,6 +10,20 @@ BodySoundManager::BodySoundManager(int index, int canvasWidth, int canvasHeight,
 	this->startTime = ofGetElapsedTimeMillis();
 	this->playing = false;
 	this->previousSequencerStep = -1;
+	this->dispatchedBar = -1;
+	this->currentlyPlayingJoints.clear();
+	this->currentlyPlaying16Joints.clear();
+	this->currentlyPlaying16Frequencies.clear();
+}
+
+void BodySoundManager::reset(int index)
+{
+	this->index = index;
+	this->startTime = ofGetElapsedTimeMillis();
+	this->previousSequencerStep = -1;
+	this->dispatchedBar = -1;
+	this->interestPoints.clear();
+	this->iP.clear();
 	this->currentlyPlayingJoints.clear();
 	this->currentlyPlaying16Joints.clear();
 	this->currentlyPlaying16Frequencies.clear();
@@ -33,8 +47,20 @@ void BodySoundManager::update()
 
 void BodySoundManager::sendOSC(int instrumentId) {
 	int sequencerStep = this->oscManager->getSequencerStep();
-	// Only send joint data to Max on the last frame of the sequencer
-	if ((sequencerStep == 0 || sequencerStep == 16) && sequencerStep != this->previousSequencerStep) {
+	SequencerClock* clock = this->oscManager->getSequencerClock();
+	uint64_t now = ofGetElapsedTimeMicros();
+	if (clock->isRunning(now)) {
+		// The next bar's pattern goes out a little before the bar starts, on the predicted clock
+		int64_t bar = clock->getBarToDispatch(now);
+		if (bar > this->dispatchedBar) {
+			// A body showing up in the middle of a bar waits for the next one
+			bool alreadyStarted = (this->dispatchedBar < 0 && now >= clock->getStepTime(bar));
+			this->dispatchedBar = bar;
+			if (!alreadyStarted) this->sendMidiSequenceOsc(instrumentId);
+		}
+	}
+	// No clock estimate yet: only send joint data to Max on the last frame of the sequencer
+	else if ((sequencerStep == 0 || sequencerStep == 16) && sequencerStep != this->previousSequencerStep) {
 		this->sendMidiSequenceOsc(instrumentId);
 	}
 	this->previousSequencerStep = sequencerStep;
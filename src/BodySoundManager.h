@@ -8,6 +8,7 @@
 class BodySoundManager {
 public:
 	BodySoundManager(int index, int canvasWidth, int canvasHeight, vector<MidiNote*> scale);
+	void reset(int index);
 	void setOscManager(MaxMSPNetworkManager* oscManager);
 	void setInterestPoints(vector<pair<JointType, ofVec2f> > points);
 	void update();
@@ -43,4 +44,6 @@ private:
 	
 	bool playing;
 	int previousSequencerStep;	
+	// Bar the last pattern was sent for, on the sequencer clock
+	int64_t dispatchedBar;
 };
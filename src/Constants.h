@@ -124,19 +124,42 @@ namespace Constants {
 	const int BODY_RECORDINGS_ID_OFFSET = 10;
 	const int MAX_BODY_RECORDINGS = 20;
 	const int MAX_INSTRUMENTS = 30;
+	const int MAX_CONTOUR_POINTS = 1000;
+	// Depth pixels a joint or contour point has to move before a sequencer thumbnail is rebuilt
+	const float SEQUENCER_CACHE_EPSILON = 1.0;
+	// Steps in one bar of the MaxMSP sequencer, and how early a bar's pattern is sent before the bar starts
+	const int SEQUENCER_STEPS = 16;
+	const float SEQUENCER_PATTERN_LOOKAHEAD_MS = 80;
 
 	const string OSC_HOST = "127.0.0.1";
 	const int OSC_PORT = 12345;
 	const int OSC_RECEIVE_PORT = 12344;
+	// Largest OSC bundle sent to MaxMSP, usually one frame's messages fit in one
+	const int MAXMSP_MAX_BUNDLE_BYTES = 8192;
 
-	const string SKELETON_DELIMITER = "__SKELETON__";
-	const string CONTOUR_DELIMITER = "__CONTOUR__";
-	const string IS_RECORDING_DELIMITER = "__IS_RECORDING__";
-	const string INSTRUMENT_ID_DELIMITER = "__INSTRUMENT_ID__";
 	const int NETWORK_TRAFFIC_MAX_LATENCY_MS = 750;	
-
-	const string CEZAR_IP = "10.147.20.54";
-	const string CY_IP = "10.147.20.159";
+	const int PEER_PING_INTERVAL_MS = 250;
+	// Body messages sent to the peer between two full contour keyframes (the rest are deltas)
+	const int PEER_KEYFRAME_INTERVAL = 10;
+	// Depth pixels the contour sent to the peer may deviate from the traced one. 0 sends the resampled contour instead
+	const float CONTOUR_TRANSMISSION_ERROR = 0;
+	// Bounds of the remote bodies' jitter buffer: most it delays playout, and extrapolates past the newest frame
+	const int JITTER_MAX_PLAYOUT_DELAY_MS = 250;
+	const int JITTER_MAX_EXTRAPOLATION_MS = 80;
+	// Body messages larger than this are split into fragments, to stay under the path MTU (1500 minus IP, UDP & OSC headers, with room for tunnels)
+	const int PEER_MAX_FRAGMENT_BYTES = 1200;
+	// How long the fragments of a body message are kept waiting for the rest of them
+	const int PEER_REASSEMBLY_TIMEOUT_MS = 250;
+
+	// Sites in one performance, counting this one
+	const int MAX_PEER_SITES = 8;
+	const string PEER_ADDRESSES = "10.147.20.54:12346, 10.147.20.159:12346";
+	const int PEER_PORT = 12346;
+
+	// Log files, in the data folder. The binary log is turned into text once it's closed
+	const string LOG_TEXT_FILE = "log.txt";
+	const string LOG_BINARY_FILE = "log.bin";
+	const string LOG_BINARY_TEXT_FILE = "log.bin.txt";
 
 	const float SHADOW_EXPECTED_FREQUENCY_SEC = 50;
 	const float SHADOW_REC_MAX_DURATION_SEC = 15;
@@ -157,12 +180,13 @@ namespace Layout {
 namespace OscCategories {
 	const string SEQUENCER_STEP = "sequencer_step";
 	const string REMOTE_BODY_DATA = "remote_body_data";
+	const string REMOTE_BODY_FRAGMENT = "remote_body_fragment";
+	const string PEER_PING = "peer_ping";
+	const string PEER_PONG = "peer_pong";
 	const string NEW_BODY = "new_body";
 
-	const string BODY_SEQUENCE = "body_sequence";
-	const string BODY_SEQUENCE_RAW = "raw_body_sequence";
-	const string BODY_IS_RECORDING = "body_is_recording";
 	const string BODY_INTERSECTION = "body_intersection";
+	const string BODY_PAIR_INTERSECTION = "body_pair_intersection";
 
 	const string BODY = "body";	
 	const string ENVIRONMENT = "env";
@@ -0,0 +1,120 @@
+#include "ContourAligner.h"
+
+ContourAligner::ContourAligner()
+{
+	this->fftSize = 0;
+}
+
+int ContourAligner::findBestOffset(const ContourBuffer& persistent, const ContourBuffer& incoming)
+{
+	const int persistentSize = persistent.size();
+	const int incomingSize = incoming.size();
+	if (persistentSize == 0 || incomingSize == 0) return 0;
+
+	// Correlating against the incoming contour repeated until it covers every offset
+	// gives us the circular correlation without any wrap-around from the FFT padding.
+	const int extendedSize = persistentSize + incomingSize - 1;
+	int size = 1;
+	while (size < extendedSize) size <<= 1;
+	this->prepare(size);
+
+	// Distances don't change under a common translation, and centering keeps the sums small.
+	const float* persistentX = persistent.getX();
+	const float* persistentY = persistent.getY();
+	const float* incomingX = incoming.getX();
+	const float* incomingY = incoming.getY();
+
+	double centerX = 0, centerY = 0;
+	for (int i = 0; i < persistentSize; i++) {
+		centerX += persistentX[i];
+		centerY += persistentY[i];
+	}
+	centerX /= persistentSize;
+	centerY /= persistentSize;
+
+	for (int i = 0; i < size; i++) {
+		if (i < persistentSize) {
+			this->persistentSpectrum[i] = complex<double>(persistentX[i] - centerX, persistentY[i] - centerY);
+		}
+		else this->persistentSpectrum[i] = 0;
+
+		if (i < extendedSize) {
+			const int index = i % incomingSize;
+			this->incomingSpectrum[i] = complex<double>(incomingX[index] - centerX, incomingY[index] - centerY);
+			this->incomingSquaredNorms[i + 1] = this->incomingSquaredNorms[i] + norm(this->incomingSpectrum[i]);
+		}
+		else this->incomingSpectrum[i] = 0;
+	}
+
+	// correlation[k] = sum(conj(persistent[i]) * incoming[i + k])
+	this->fft(this->persistentSpectrum, false);
+	this->fft(this->incomingSpectrum, false);
+	for (int i = 0; i < size; i++) {
+		this->incomingSpectrum[i] *= conj(this->persistentSpectrum[i]);
+	}
+	this->fft(this->incomingSpectrum, true);
+
+	// |a - b|^2 = |a|^2 + |b|^2 - 2 Re(conj(a) * b), |a|^2 is the same for every offset
+	int bestOffset = 0;
+	double bestDistance = 0;
+	for (int offset = 0; offset < incomingSize; offset++) {
+		double incomingNorms = this->incomingSquaredNorms[offset + persistentSize] - this->incomingSquaredNorms[offset];
+		double distance = incomingNorms - 2.0 * this->incomingSpectrum[offset].real() / size;
+		if (offset == 0 || distance < bestDistance) {
+			bestOffset = offset;
+			bestDistance = distance;
+		}
+	}
+
+	return bestOffset;
+}
+
+void ContourAligner::prepare(int size)
+{
+	if (size == this->fftSize) return;
+	this->fftSize = size;
+
+	this->persistentSpectrum.resize(size);
+	this->incomingSpectrum.resize(size);
+	this->incomingSquaredNorms.assign(size + 1, 0);
+
+	this->twiddles.resize(size / 2);
+	for (int i = 0; i < size / 2; i++) {
+		double angle = -TWO_PI * i / size;
+		this->twiddles[i] = complex<double>(cos(angle), sin(angle));
+	}
+
+	int bits = 0;
+	while ((1 << bits) < size) bits++;
+	this->bitReversal.resize(size);
+	for (int i = 0; i < size; i++) {
+		int reversed = 0;
+		for (int b = 0; b < bits; b++) {
+			if (i & (1 << b)) reversed |= 1 << (bits - 1 - b);
+		}
+		this->bitReversal[i] = reversed;
+	}
+}
+
+// In-place iterative radix-2 FFT. The inverse transform is left unscaled.
+void ContourAligner::fft(vector<complex<double> >& data, bool inverse)
+{
+	const int size = this->fftSize;
+	for (int i = 0; i < size; i++) {
+		if (i < this->bitReversal[i]) swap(data[i], data[this->bitReversal[i]]);
+	}
+
+	for (int length = 2; length <= size; length <<= 1) {
+		const int half = length / 2;
+		const int twiddleStep = size / length;
+		for (int start = 0; start < size; start += length) {
+			for (int i = 0; i < half; i++) {
+				complex<double> w = this->twiddles[i * twiddleStep];
+				if (inverse) w = conj(w);
+				complex<double> odd = data[start + i + half] * w;
+				data[start + i + half] = data[start + i] - odd;
+				data[start + i] += odd;
+			}
+		}
+	}
+}
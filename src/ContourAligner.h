@@ -0,0 +1,32 @@
+#pragma once
+
+#include <complex>
+#include "ofMain.h"
+#include "ContourBuffer.h"
+
+#ifndef CONTOUR_ALIGNER_H
+#define CONTOUR_ALIGNER_H
+
+using namespace std;
+
+// Finds the circular index offset of a new contour which best matches a persistent one,
+// i.e. the offset k minimizing sum(|persistent[i] - incoming[(i + k) % n]|^2).
+// All offsets are evaluated at once through an FFT cross-correlation, in O(N log N).
+class ContourAligner {
+public:
+	ContourAligner();
+	int findBestOffset(const ContourBuffer& persistent, const ContourBuffer& incoming);
+
+private:
+	int fftSize;
+	vector<complex<double> > persistentSpectrum;
+	vector<complex<double> > incomingSpectrum;
+	vector<complex<double> > twiddles;
+	vector<int> bitReversal;
+	vector<double> incomingSquaredNorms;
+
+	void prepare(int size);
+	void fft(vector<complex<double> >& data, bool inverse);
+};
+
+#endif
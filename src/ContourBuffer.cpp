@@ -0,0 +1,152 @@
+#include "ContourBuffer.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CONTOUR_BUFFER_AVX
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CONTOUR_BUFFER_SSE
+#endif
+
+// destination[i] = (1 - smoothing) * source[i] + smoothing * destination[i]
+static void smoothRange(float* destination, const float* source, int count, float smoothing)
+{
+	const float weight = 1 - smoothing;
+	int i = 0;
+
+#ifdef CONTOUR_BUFFER_AVX
+	const __m256 weight8 = _mm256_set1_ps(weight);
+	const __m256 smoothing8 = _mm256_set1_ps(smoothing);
+	for (; i + 8 <= count; i += 8) {
+		__m256 s = _mm256_loadu_ps(source + i);
+		__m256 d = _mm256_loadu_ps(destination + i);
+		_mm256_storeu_ps(destination + i, _mm256_add_ps(_mm256_mul_ps(weight8, s), _mm256_mul_ps(smoothing8, d)));
+	}
+#endif
+
+#ifdef CONTOUR_BUFFER_SSE
+	const __m128 weight4 = _mm_set1_ps(weight);
+	const __m128 smoothing4 = _mm_set1_ps(smoothing);
+	for (; i + 4 <= count; i += 4) {
+		__m128 s = _mm_loadu_ps(source + i);
+		__m128 d = _mm_loadu_ps(destination + i);
+		_mm_storeu_ps(destination + i, _mm_add_ps(_mm_mul_ps(weight4, s), _mm_mul_ps(smoothing4, d)));
+	}
+#endif
+
+	for (; i < count; i++) {
+		destination[i] = weight * source[i] + smoothing * destination[i];
+	}
+}
+
+ContourBuffer::ContourBuffer()
+{
+}
+
+void ContourBuffer::resize(int size)
+{
+	this->x.resize(size);
+	this->y.resize(size);
+}
+
+void ContourBuffer::reserve(int capacity)
+{
+	this->x.reserve(capacity);
+	this->y.reserve(capacity);
+}
+
+void ContourBuffer::clear()
+{
+	this->x.clear();
+	this->y.clear();
+}
+
+int ContourBuffer::size() const
+{
+	return this->x.size();
+}
+
+int ContourBuffer::capacity() const
+{
+	return this->x.capacity();
+}
+
+void ContourBuffer::addPoint(float x, float y)
+{
+	this->x.push_back(x);
+	this->y.push_back(y);
+}
+
+void ContourBuffer::setPoint(int index, float x, float y)
+{
+	this->x[index] = x;
+	this->y[index] = y;
+}
+
+ofVec2f ContourBuffer::getPoint(int index) const
+{
+	return ofVec2f(this->x[index], this->y[index]);
+}
+
+float* ContourBuffer::getX()
+{
+	return this->x.data();
+}
+
+float* ContourBuffer::getY()
+{
+	return this->y.data();
+}
+
+const float* ContourBuffer::getX() const
+{
+	return this->x.data();
+}
+
+const float* ContourBuffer::getY() const
+{
+	return this->y.data();
+}
+
+// Signed area, same convention as ofPolyline::getArea
+float ContourBuffer::getArea() const
+{
+	const int n = this->size();
+	if (n < 3) return 0;
+
+	float area = 0;
+	for (int i = 0; i < n - 1; i++) {
+		area += this->x[i] * this->y[i + 1] - this->x[i + 1] * this->y[i];
+	}
+	area += this->x[n - 1] * this->y[0] - this->x[0] * this->y[n - 1];
+	return area * 0.5f;
+}
+
+void ContourBuffer::smoothTowards(const ContourBuffer& target, int offset, float smoothing)
+{
+	const int n = this->size();
+	const int targetSize = target.size();
+	if (n == 0 || targetSize == 0) return;
+
+	// Instead of a modulo per vertex, split the circular offset into contiguous ranges
+	// (two of them when both contours have the same size).
+	int start = 0;
+	while (start < n) {
+		int targetStart = (start + offset) % targetSize;
+		int count = min(n - start, targetSize - targetStart);
+		smoothRange(this->x.data() + start, target.x.data() + targetStart, count, smoothing);
+		smoothRange(this->y.data() + start, target.y.data() + targetStart, count, smoothing);
+		start += count;
+	}
+}
+
+void ContourBuffer::toPolyline(ofPolyline& polyline) const
+{
+	polyline.clear();
+	for (int i = 0; i < this->size(); i++) {
+		polyline.addVertex(this->x[i], this->y[i]);
+	}
+	polyline.close();
+}
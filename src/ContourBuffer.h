@@ -0,0 +1,68 @@
+#pragma once
+
+#include <xmmintrin.h>
+#include "ofMain.h"
+
+#ifndef CONTOUR_BUFFER_H
+#define CONTOUR_BUFFER_H
+
+using namespace std;
+
+// Allocator for the coordinate arrays, so SIMD loads start on a 32 byte boundary.
+template <typename T>
+class AlignedAllocator {
+public:
+	typedef T value_type;
+	static const size_t ALIGNMENT = 32;
+
+	AlignedAllocator() {}
+	template <typename U> AlignedAllocator(const AlignedAllocator<U>& other) {}
+
+	T* allocate(size_t n) {
+		void* p = _mm_malloc(n * sizeof(T), ALIGNMENT);
+		if (p == NULL) throw bad_alloc();
+		return static_cast<T*>(p);
+	}
+
+	void deallocate(T* p, size_t n) {
+		_mm_free(p);
+	}
+};
+
+template <typename T, typename U> bool operator==(const AlignedAllocator<T>& a, const AlignedAllocator<U>& b) { return true; }
+template <typename T, typename U> bool operator!=(const AlignedAllocator<T>& a, const AlignedAllocator<U>& b) { return false; }
+
+// Closed contour, stored as separate x / y arrays (structure of arrays) instead of ofPolyline's
+// array of 3D points, so per-vertex processing can run on 4 / 8 vertices at a time.
+// Convert to an ofPolyline only where a drawing or clipping API needs one.
+class ContourBuffer {
+public:
+	ContourBuffer();
+
+	void resize(int size);
+	void reserve(int capacity);
+	void clear();
+	int size() const;
+	int capacity() const;
+
+	void addPoint(float x, float y);
+	void setPoint(int index, float x, float y);
+	ofVec2f getPoint(int index) const;
+
+	float* getX();
+	float* getY();
+	const float* getX() const;
+	const float* getY() const;
+
+	float getArea() const;
+
+	// this[i] = smoothing * this[i] + (1 - smoothing) * target[(i + offset) % target.size()]
+	void smoothTowards(const ContourBuffer& target, int offset, float smoothing);
+	void toPolyline(ofPolyline& polyline) const;
+
+private:
+	vector<float, AlignedAllocator<float> > x;
+	vector<float, AlignedAllocator<float> > y;
+};
+
+#endif
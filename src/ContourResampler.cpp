@@ -0,0 +1,69 @@
+#include "ContourResampler.h"
+
+int ContourResampler::allocationCount = 0;
+
+ContourResampler::ContourResampler()
+{
+	this->source = NULL;
+}
+
+void ContourResampler::setSource(const ContourBuffer& source)
+{
+	this->source = &source;
+	const int n = source.size();
+	const float* x = source.getX();
+	const float* y = source.getY();
+
+	if (this->cumulativeLengths.capacity() < n + 1) ContourResampler::allocationCount++;
+	this->cumulativeLengths.resize(n + 1);
+	this->cumulativeLengths[0] = 0;
+
+	for (int i = 0; i < n; i++) {
+		const int next = (i + 1 < n) ? i + 1 : 0;
+		const float dx = x[next] - x[i];
+		const float dy = y[next] - y[i];
+		this->cumulativeLengths[i + 1] = this->cumulativeLengths[i] + sqrt(dx * dx + dy * dy);
+	}
+}
+
+float ContourResampler::getPerimeter()
+{
+	if (this->cumulativeLengths.size() == 0) return 0;
+	return this->cumulativeLengths.back();
+}
+
+// Evenly spaced points along the (closed) source contour, like ofPolyline::getResampledByCount
+void ContourResampler::resample(int count, ContourBuffer& resampled)
+{
+	const int n = (this->source == NULL) ? 0 : this->source->size();
+	if (n == 0 || count <= 0) {
+		resampled.clear();
+		return;
+	}
+
+	if (resampled.capacity() < count) ContourResampler::allocationCount++;
+	resampled.resize(count);
+
+	const float* x = this->source->getX();
+	const float* y = this->source->getY();
+	float* resampledX = resampled.getX();
+	float* resampledY = resampled.getY();
+
+	const float spacing = this->getPerimeter() / count;
+	int segment = 0;
+	for (int k = 0; k < count; k++) {
+		const float distance = k * spacing;
+		while (segment < n - 1 && this->cumulativeLengths[segment + 1] < distance) segment++;
+
+		const int next = (segment + 1 < n) ? segment + 1 : 0;
+		const float segmentLength = this->cumulativeLengths[segment + 1] - this->cumulativeLengths[segment];
+		float t = (segmentLength > 0) ? ofClamp((distance - this->cumulativeLengths[segment]) / segmentLength, 0, 1) : 0;
+		resampledX[k] = x[segment] + t * (x[next] - x[segment]);
+		resampledY[k] = y[segment] + t * (y[next] - y[segment]);
+	}
+}
+
+int ContourResampler::getAllocationCount()
+{
+	return ContourResampler::allocationCount;
+}
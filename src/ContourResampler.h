@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ContourBuffer.h"
+
+#ifndef CONTOUR_RESAMPLER_H
+#define CONTOUR_RESAMPLER_H
+
+using namespace std;
+
+// Arc-length resampling of a closed contour into preallocated buffers.
+// setSource does the only pass over the source's segment lengths (kept as a cumulative table),
+// every resample call after that reuses it, whatever the number of points asked for.
+// The source has to stay untouched between setSource and the resample calls.
+class ContourResampler {
+public:
+	ContourResampler();
+
+	void setSource(const ContourBuffer& source);
+	void resample(int count, ContourBuffer& resampled);
+	float getPerimeter();
+
+	// Number of times any resampler had to grow a buffer; stays flat once every buffer is warm.
+	static int getAllocationCount();
+
+private:
+	const ContourBuffer* source;
+	vector<float> cumulativeLengths;
+
+	static int allocationCount;
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include "ContourSimplifier.h"
+
+ContourSimplifier::ContourSimplifier()
+{
+}
+
+void ContourSimplifier::simplify(const ContourBuffer& source, float maxError, int maxPoints, ContourBuffer& simplified)
+{
+	const int n = source.size();
+	if (n <= 3 || maxError <= 0) {
+		simplified = source;
+		return;
+	}
+
+	const float* x = source.getX();
+	const float* y = source.getY();
+
+	int farthest = 0;
+	float farthestDistance = -1;
+	for (int i = 1; i < n; i++) {
+		float dx = x[i] - x[0];
+		float dy = y[i] - y[0];
+		float d = dx * dx + dy * dy;
+		if (d > farthestDistance) {
+			farthestDistance = d;
+			farthest = i;
+		}
+	}
+
+	this->keep.assign(n, 0);
+	this->keep[0] = this->keep[farthest] = 1;
+	int kept = 2;
+
+	const float maxSquaredError = maxError * maxError;
+	this->heap.clear();
+	this->addSegment(x, y, n, 0, farthest, maxSquaredError);
+	this->addSegment(x, y, n, farthest, n, maxSquaredError);
+
+	while (this->heap.size() > 0 && kept < maxPoints) {
+		pop_heap(this->heap.begin(), this->heap.end());
+		const Segment segment = this->heap.back();
+		this->heap.pop_back();
+
+		this->keep[segment.worst] = 1;
+		kept++;
+		this->addSegment(x, y, n, segment.a, segment.worst, maxSquaredError);
+		this->addSegment(x, y, n, segment.worst, segment.b, maxSquaredError);
+	}
+
+	simplified.resize(kept);
+	float* simplifiedX = simplified.getX();
+	float* simplifiedY = simplified.getY();
+	int k = 0;
+	for (int i = 0; i < n; i++) {
+		if (!this->keep[i]) continue;
+		simplifiedX[k] = x[i];
+		simplifiedY[k] = y[i];
+		k++;
+	}
+}
+
+void ContourSimplifier::addSegment(const float* x, const float* y, int n, int a, int b, float maxSquaredError)
+{
+	if (b - a < 2) return;
+
+	const float ax = x[a], ay = y[a];
+	const float sx = x[b % n] - ax, sy = y[b % n] - ay;
+	const float squaredLength = sx * sx + sy * sy;
+
+	int worst = -1;
+	float worstDistance = maxSquaredError;
+	for (int i = a + 1; i < b; i++) {
+		float px = x[i] - ax, py = y[i] - ay;
+		// Distance to the segment, not the line, so points past either end are measured correctly
+		float t = (squaredLength > 0) ? ofClamp((px * sx + py * sy) / squaredLength, 0, 1) : 0;
+		float dx = px - t * sx, dy = py - t * sy;
+		float d = dx * dx + dy * dy;
+		if (d > worstDistance) {
+			worstDistance = d;
+			worst = i;
+		}
+	}
+	if (worst < 0) return;
+
+	Segment segment;
+	segment.distance = worstDistance;
+	segment.a = a;
+	segment.b = b;
+	segment.worst = worst;
+	this->heap.push_back(segment);
+	push_heap(this->heap.begin(), this->heap.end());
+}
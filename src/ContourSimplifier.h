@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ContourBuffer.h"
+
+#ifndef CONTOUR_SIMPLIFIER_H
+#define CONTOUR_SIMPLIFIER_H
+
+using namespace std;
+
+// Ramer-Douglas-Peucker simplification of a closed contour: keeps the fewest vertices for which
+// every dropped point lies within maxError (depth pixels) of the simplified outline.
+// The contour is split at its first point and the point farthest from it, then the segment whose farthest
+// point is the worst is always split next (a heap keyed by that distance), so when maxPoints cuts the
+// refinement short the error is spread evenly over the outline. No recursion, and no allocation once
+// buffers are warm.
+class ContourSimplifier {
+public:
+	ContourSimplifier();
+
+	// Output is capped at maxPoints, whatever the error bound
+	void simplify(const ContourBuffer& source, float maxError, int maxPoints, ContourBuffer& simplified);
+
+private:
+	struct Segment {
+		// Squared distance of the segment's worst point
+		float distance;
+		// [a, b] with b == n standing for point 0, closing the contour
+		int a, b;
+		int worst;
+		bool operator<(const Segment& other) const { return this->distance < other.distance; }
+	};
+
+	vector<char> keep;
+	vector<Segment> heap;
+
+	// Queues [a, b] if some point of it lies farther than the error bound from the segment
+	void addSegment(const float* x, const float* y, int n, int a, int b, float maxSquaredError);
+};
+
+#endif
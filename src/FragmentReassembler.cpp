@@ -0,0 +1,147 @@
+#include "FragmentReassembler.h"
+
+FragmentReassembler::FragmentReassembler()
+{
+	this->slots.resize(SLOTS);
+	this->clear();
+	this->fragmentsReceived = 0;
+	this->messagesReassembled = 0;
+	this->messagesLost = 0;
+	this->duplicateFragments = 0;
+	this->malformedFragments = 0;
+}
+
+void FragmentReassembler::clear()
+{
+	for (int i = 0; i < SLOTS; i++) this->slots[i].used = false;
+	this->finishedCount = 0;
+	this->hasNewest = false;
+}
+
+FragmentReassembler::Result FragmentReassembler::add(uint32_t messageId, int fragmentIndex, int fragmentCount, const ofBuffer& fragment, uint64_t now, ofBuffer& message)
+{
+	if (fragmentCount < 1 || fragmentCount > MAX_FRAGMENTS || fragmentIndex < 0 || fragmentIndex >= fragmentCount) {
+		this->malformedFragments++;
+		return DROPPED;
+	}
+	this->fragmentsReceived++;
+
+	// Far behind the newest message means long finished, unless the sender restarted and its ids start over
+	bool isRecent = this->hasNewest && now - this->newestArrival < Constants::NETWORK_TRAFFIC_MAX_LATENCY_MS;
+	if (this->isFinished(messageId) || (isRecent && (int32_t)(messageId - this->newestMessageId) < -(SLOTS * 2))) {
+		this->duplicateFragments++;
+		return DROPPED;
+	}
+
+	// Slot of the message, or a free one, or the oldest one
+	int slotIndex = -1, freeIndex = -1, oldestIndex = 0;
+	for (int i = 0; i < SLOTS; i++) {
+		const Slot& slot = this->slots[i];
+		if (!slot.used) {
+			if (freeIndex < 0) freeIndex = i;
+			continue;
+		}
+		if (slot.messageId == messageId) {
+			slotIndex = i;
+			break;
+		}
+		if (!this->slots[oldestIndex].used || slot.firstArrival < this->slots[oldestIndex].firstArrival) oldestIndex = i;
+	}
+
+	if (slotIndex < 0) {
+		if (freeIndex >= 0) {
+			slotIndex = freeIndex;
+		}
+		else {
+			slotIndex = oldestIndex;
+			this->messagesLost++;
+			this->finish(this->slots[slotIndex]);
+		}
+		Slot& slot = this->slots[slotIndex];
+		slot.used = true;
+		slot.messageId = messageId;
+		slot.fragmentCount = fragmentCount;
+		slot.receivedCount = 0;
+		slot.receivedMask = 0;
+		slot.firstArrival = now;
+		if ((int)slot.fragments.size() < fragmentCount) slot.fragments.resize(fragmentCount);
+	}
+
+	Slot& slot = this->slots[slotIndex];
+	if (slot.fragmentCount != fragmentCount) {
+		this->malformedFragments++;
+		return DROPPED;
+	}
+	uint64_t bit = (uint64_t)1 << fragmentIndex;
+	if (slot.receivedMask & bit) {
+		this->duplicateFragments++;
+		return DROPPED;
+	}
+	slot.receivedMask |= bit;
+	slot.receivedCount++;
+	slot.fragments[fragmentIndex].assign(fragment.getData(), fragment.getData() + fragment.size());
+	if (!isRecent || (int32_t)(messageId - this->newestMessageId) > 0) this->newestMessageId = messageId;
+	this->hasNewest = true;
+	this->newestArrival = now;
+	if (slot.receivedCount < slot.fragmentCount) return STORED;
+
+	this->assembled.clear();
+	for (int i = 0; i < slot.fragmentCount; i++) {
+		this->assembled.insert(this->assembled.end(), slot.fragments[i].begin(), slot.fragments[i].end());
+	}
+	message.set(this->assembled.data(), this->assembled.size());
+
+	this->messagesReassembled++;
+	this->finish(slot);
+	return COMPLETED;
+}
+
+void FragmentReassembler::expire(uint64_t now)
+{
+	for (int i = 0; i < SLOTS; i++) {
+		Slot& slot = this->slots[i];
+		if (!slot.used || now - slot.firstArrival < Constants::PEER_REASSEMBLY_TIMEOUT_MS) continue;
+		this->messagesLost++;
+		this->finish(slot);
+	}
+}
+
+bool FragmentReassembler::isFinished(uint32_t messageId)
+{
+	for (int i = 0; i < min(this->finishedCount, SLOTS * 2); i++) {
+		if (this->finishedIds[i] == messageId) return true;
+	}
+	return false;
+}
+
+void FragmentReassembler::finish(Slot& slot)
+{
+	this->finishedIds[this->finishedCount % (SLOTS * 2)] = slot.messageId;
+	this->finishedCount++;
+	slot.used = false;
+}
+
+int FragmentReassembler::getFragmentsReceived()
+{
+	return this->fragmentsReceived;
+}
+
+int FragmentReassembler::getMessagesReassembled()
+{
+	return this->messagesReassembled;
+}
+
+int FragmentReassembler::getMessagesLost()
+{
+	return this->messagesLost;
+}
+
+int FragmentReassembler::getDuplicateFragments()
+{
+	return this->duplicateFragments;
+}
+
+int FragmentReassembler::getMalformedFragments()
+{
+	return this->malformedFragments;
+}
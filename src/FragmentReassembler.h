@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+#include "ofMain.h"
+#include "Constants.h"
+
+#ifndef FRAGMENT_REASSEMBLER_H
+#define FRAGMENT_REASSEMBLER_H
+
+using namespace std;
+
+// Puts body messages which were too large for a single datagram back together.
+// The sender splits a message into fragmentCount pieces of at most PEER_MAX_FRAGMENT_BYTES and tags each of
+// them with a message id (counting up per sender) and its index. Pieces may come in any order.
+// At most SLOTS messages are put together at once: a message still missing pieces after
+// PEER_REASSEMBLY_TIMEOUT_MS, or the oldest one when a new message needs a slot, counts as lost.
+// Pieces of a message which was already completed or given up on are dropped, as are pieces of messages
+// more than SLOTS * 2 ids behind the newest one (ids start over when nothing new came in for a while).
+class FragmentReassembler {
+public:
+	FragmentReassembler();
+	void clear();
+
+	enum Result {
+		// Malformed, duplicate or too late
+		DROPPED,
+		STORED,
+		// Completed its message, which is then in message
+		COMPLETED
+	};
+	Result add(uint32_t messageId, int fragmentIndex, int fragmentCount, const ofBuffer& fragment, uint64_t now, ofBuffer& message);
+	// Gives up on messages which waited too long
+	void expire(uint64_t now);
+
+	int getFragmentsReceived();
+	int getMessagesReassembled();
+	int getMessagesLost();
+	int getDuplicateFragments();
+	int getMalformedFragments();
+
+	static const int SLOTS = 16;
+	static const int MAX_FRAGMENTS = 64;
+
+private:
+	struct Slot {
+		bool used;
+		uint32_t messageId;
+		int fragmentCount;
+		int receivedCount;
+		uint64_t receivedMask;
+		uint64_t firstArrival;
+		vector<vector<char> > fragments;
+	};
+
+	vector<Slot> slots;
+	vector<char> assembled;
+
+	// Ids of the last messages completed or given up on
+	uint32_t finishedIds[SLOTS * 2];
+	int finishedCount;
+	bool hasNewest;
+	uint32_t newestMessageId;
+	uint64_t newestArrival;
+
+	int fragmentsReceived;
+	int messagesReassembled;
+	int messagesLost;
+	int duplicateFragments;
+	int malformedFragments;
+
+	bool isFinished(uint32_t messageId);
+	void finish(Slot& slot);
+};
+
+#endif
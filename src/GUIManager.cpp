@@ -48,6 +48,12 @@ void GUIManager::update(TrackedBody* leftBody, TrackedBody* rightBody, int curre
 	this->updateBackgroundContours();
 }
 
+void GUIManager::setSessionStatus(string siteStatus, string peerStatus)
+{
+	this->siteStatus = siteStatus;
+	this->peerStatus = peerStatus;
+}
+
 void GUIManager::updateSequencer()
 {
 	this->sequencerLeft->setTrackedBody(this->leftBody);
@@ -60,6 +66,12 @@ void GUIManager::updateSequencer()
 	this->sequencerRight->update();
 }
 
+void GUIManager::setSequencerCacheEpsilon(float cacheEpsilon)
+{
+	this->sequencerLeft->setCacheEpsilon(cacheEpsilon);
+	this->sequencerRight->setCacheEpsilon(cacheEpsilon);
+}
+
 void GUIManager::updateBackgroundContours()
 {
 	ofVec2f winSize = ofGetWindowSize() / 2.0;
@@ -129,17 +141,17 @@ void GUIManager::drawSystemStatus()
 	string status = isConnected ? "Connected" : "Not Connected";
 	fontRegular.drawString(status, Layout::WINDOW_PADDING + width, Layout::WINDOW_PADDING - 7);
 
-	// IP 1
-	width = fontBold.stringWidth("IP_1_ ");
-	totalWidth = width + fontRegular.stringWidth(Constants::CEZAR_IP);
-	fontBold.drawString("IP_1_ ", (ofGetWindowWidth() - totalWidth) / 2, Layout::WINDOW_PADDING - 7);
-	fontRegular.drawString(Constants::CEZAR_IP, (ofGetWindowWidth() - totalWidth) / 2 + width, Layout::WINDOW_PADDING - 7);
+	// Site
+	width = fontBold.stringWidth("Site_ ");
+	totalWidth = width + fontRegular.stringWidth(siteStatus);
+	fontBold.drawString("Site_ ", (ofGetWindowWidth() - totalWidth) / 2, Layout::WINDOW_PADDING - 7);
+	fontRegular.drawString(siteStatus, (ofGetWindowWidth() - totalWidth) / 2 + width, Layout::WINDOW_PADDING - 7);
 
-	// IP 2
-	width = fontBold.stringWidth("IP_2_ ");
-	totalWidth = width + fontRegular.stringWidth(Constants::CY_IP);
-	fontBold.drawString("IP_2_ ", ofGetWindowWidth() - Layout::WINDOW_PADDING - totalWidth, Layout::WINDOW_PADDING - 7);
-	fontRegular.drawString(Constants::CY_IP, ofGetWindowWidth() - Layout::WINDOW_PADDING - totalWidth + width, Layout::WINDOW_PADDING - 7);
+	// Peers
+	width = fontBold.stringWidth("Peers_ ");
+	totalWidth = width + fontRegular.stringWidth(peerStatus);
+	fontBold.drawString("Peers_ ", ofGetWindowWidth() - Layout::WINDOW_PADDING - totalWidth, Layout::WINDOW_PADDING - 7);
+	fontRegular.drawString(peerStatus, ofGetWindowWidth() - Layout::WINDOW_PADDING - totalWidth + width, Layout::WINDOW_PADDING - 7);
 
 	// Instrument 1
 	if (leftBody != NULL) {
@@ -166,10 +178,10 @@ void GUIManager::drawSystemStatus()
 		ofPopMatrix();
 	}
 
-	// Latency
-	width = fontBold.stringWidth("Latency_ ");
+	// Latency: one-way delay of the peer's data, measured against its clock
+	width = fontBold.stringWidth("One_way_delay_ ");
 	totalWidth = width + fontRegular.stringWidth(latency);
-	fontBold.drawString("Latency_ ", (ofGetWindowWidth() - totalWidth) / 2, ofGetWindowHeight() - Layout::WINDOW_PADDING + 15);
+	fontBold.drawString("One_way_delay_ ", (ofGetWindowWidth() - totalWidth) / 2, ofGetWindowHeight() - Layout::WINDOW_PADDING + 15);
 	fontRegular.drawString(latency, (ofGetWindowWidth() - totalWidth) / 2 + width, ofGetWindowHeight() - Layout::WINDOW_PADDING + 15);
 
 	ofPopStyle();
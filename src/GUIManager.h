@@ -19,6 +19,10 @@ public:
 	int currentSequencerStep;
 	bool isConnected;
 	string latency;
+	// This site's id & how many peers are connected
+	string siteStatus;
+	string peerStatus;
+	void setSessionStatus(string siteStatus, string peerStatus);
 
 	// UI component at the bottom, for drawing current sound frequency
 	ofMesh frequencyGradient;
@@ -27,6 +31,7 @@ public:
 	Sequencer* sequencerLeft;
 	Sequencer* sequencerRight;
 	void updateSequencer();
+	void setSequencerCacheEpsilon(float cacheEpsilon);
 	void drawSequencer();
 
 	// Body contour tracing backgrounds
@@ -10,10 +10,10 @@ float GeometryUtils::getVectorAngleDeg(ofVec2f a, ofVec2f b)
 	return getVectorAngle(a, b) * 180 / PI;
 }
 
-float GeometryUtils::getPolylineSquaredDistanceWithOffset(ofPolyline a, ofPolyline b, int offset)
+float GeometryUtils::getPolylineSquaredDistanceWithOffset(const ofPolyline& a, const ofPolyline& b, int offset)
 {
-	auto aV = a.getVertices();
-	auto bV = b.getVertices();
+	const auto& aV = a.getVertices();
+	const auto& bV = b.getVertices();
 	float distance = 0;
 	for (int i = 0; i < aV.size(); i++) {
 		int bIndex = (i + offset) % bV.size();
@@ -5,5 +5,5 @@ class GeometryUtils {
 public:
 	static float getVectorAngle(ofVec2f a, ofVec2f b);
 	static float getVectorAngleDeg(ofVec2f a, ofVec2f b);
-	static float getPolylineSquaredDistanceWithOffset(ofPolyline a, ofPolyline b, int offset);
+	static float getPolylineSquaredDistanceWithOffset(const ofPolyline& a, const ofPolyline& b, int offset);
 };
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "GpuResourcePool.h"
+
+GpuResourcePool* GpuResourcePool::instance = NULL;
+GpuResourceBackend GpuResourcePool::defaultBackend;
+
+bool GpuResourceBackend::loadShader(ofShader& shader, const string& path)
+{
+	return shader.load(path);
+}
+
+void GpuResourceBackend::allocateFbo(ofFbo& fbo, int width, int height)
+{
+	fbo.allocate(width, height);
+}
+
+GpuResourcePool* GpuResourcePool::getInstance()
+{
+	if (GpuResourcePool::instance == NULL) GpuResourcePool::instance = new GpuResourcePool();
+	return GpuResourcePool::instance;
+}
+
+GpuResourcePool::GpuResourcePool()
+{
+	this->backend = &GpuResourcePool::defaultBackend;
+	this->leasedFboCount = 0;
+}
+
+void GpuResourcePool::setBackend(GpuResourceBackend* backend)
+{
+	this->backend = (backend == NULL) ? &GpuResourcePool::defaultBackend : backend;
+}
+
+void GpuResourcePool::preload(const vector<string>& shaderNames, int fboWidth, int fboHeight, int fboCount)
+{
+	for (auto& name : shaderNames) {
+		this->getShader(name);
+	}
+
+	vector<ofFbo*> warm;
+	for (int i = 0; i < fboCount; i++) {
+		warm.push_back(this->acquireFbo(fboWidth, fboHeight));
+	}
+	for (auto fbo : warm) {
+		this->releaseFbo(fbo);
+	}
+}
+
+ofShader* GpuResourcePool::getShader(const string& name)
+{
+	auto it = this->shaders.find(name);
+	if (it != this->shaders.end()) return it->second;
+
+	ofShader* shader = new ofShader();
+	if (!this->backend->loadShader(*shader, "shaders_gl3/" + name)) {
+		ofLogError() << "Could not load shader: " << name;
+	}
+	this->shaders[name] = shader;
+	return shader;
+}
+
+ofFbo* GpuResourcePool::acquireFbo(int width, int height)
+{
+	for (auto& entry : this->fbos) {
+		if (entry.leased || entry.width != width || entry.height != height) continue;
+		entry.leased = true;
+		this->leasedFboCount++;
+		return entry.fbo;
+	}
+
+	FboEntry entry;
+	entry.fbo = new ofFbo();
+	entry.width = width;
+	entry.height = height;
+	entry.leased = true;
+	this->backend->allocateFbo(*entry.fbo, width, height);
+	this->fbos.push_back(entry);
+	this->leasedFboCount++;
+	return entry.fbo;
+}
+
+void GpuResourcePool::releaseFbo(ofFbo* fbo)
+{
+	if (fbo == NULL) return;
+
+	for (auto& entry : this->fbos) {
+		if (entry.fbo != fbo) continue;
+		if (entry.leased) {
+			entry.leased = false;
+			this->leasedFboCount--;
+		}
+		return;
+	}
+
+	LOG_WARNING("Released an FBO which doesn't belong to the pool");
+}
+
+int GpuResourcePool::getShaderCount()
+{
+	return this->shaders.size();
+}
+
+int GpuResourcePool::getFboCount()
+{
+	return this->fbos.size();
+}
+
+int GpuResourcePool::getLeasedFboCount()
+{
+	return this->leasedFboCount;
+}
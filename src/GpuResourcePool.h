@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ofMain.h"
+#include "AsyncLogger.h"
+
+#ifndef GPU_RESOURCE_POOL_H
+#define GPU_RESOURCE_POOL_H
+
+using namespace std;
+
+// The calls which actually touch the GPU. Replace with a stub to exercise the pool without a GL context.
+class GpuResourceBackend {
+public:
+	virtual ~GpuResourceBackend() {}
+	virtual bool loadShader(ofShader& shader, const string& path);
+	virtual void allocateFbo(ofFbo& fbo, int width, int height);
+};
+
+// Process wide registry of GPU resources shared by all bodies.
+// Each shader program is compiled once, FBOs are leased and go back to the pool when released,
+// so bodies appearing mid-performance don't load or allocate anything.
+class GpuResourcePool {
+public:
+	static GpuResourcePool* getInstance();
+
+	void setBackend(GpuResourceBackend* backend);
+
+	// Compiles the shaders and allocates the FBOs up front, at start-up
+	void preload(const vector<string>& shaderNames, int fboWidth, int fboHeight, int fboCount);
+
+	ofShader* getShader(const string& name);
+	ofFbo* acquireFbo(int width, int height);
+	void releaseFbo(ofFbo* fbo);
+
+	int getShaderCount();
+	int getFboCount();
+	int getLeasedFboCount();
+
+private:
+	GpuResourcePool();
+
+	struct FboEntry {
+		ofFbo* fbo;
+		int width;
+		int height;
+		bool leased;
+	};
+
+	GpuResourceBackend* backend;
+	map<string, ofShader*> shaders;
+	vector<FboEntry> fbos;
+	int leasedFboCount;
+
+	static GpuResourcePool* instance;
+	static GpuResourceBackend defaultBackend;
+};
+
+#endif
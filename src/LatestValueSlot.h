@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include "ofMain.h"
+
+#ifndef LATEST_VALUE_SLOT_H
+#define LATEST_VALUE_SLOT_H
+
+using namespace std;
+
+// Hands the most recent value from one writer thread to one reader thread, without locks and without
+// ever blocking either side (triple buffering). Values published in between two reads are skipped.
+template <typename T>
+class LatestValueSlot {
+public:
+	LatestValueSlot() : back(0), middle(1), front(2) {}
+
+	// Writer: fill this, then publish() it
+	T& getBack() { return this->values[this->back]; }
+
+	void publish() {
+		this->back = this->middle.exchange(this->back | FRESH, memory_order_acq_rel) & INDEX;
+	}
+
+	// Reader: true (and get() moves to it) if a value was published since the last call
+	bool update() {
+		if (!(this->middle.load(memory_order_relaxed) & FRESH)) return false;
+		this->front = this->middle.exchange(this->front, memory_order_acq_rel) & INDEX;
+		return true;
+	}
+
+	const T& get() { return this->values[this->front]; }
+
+private:
+	static const int INDEX = 3;
+	static const int FRESH = 4;
+
+	T values[3];
+	int back;
+	atomic<int> middle;
+	int front;
+};
+
+#endif
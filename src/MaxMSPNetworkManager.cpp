@@ -1,13 +1,42 @@
 #include "MaxMSPNetworkManager.h"
 
-MaxMSPNetworkManager::MaxMSPNetworkManager(string host, int port, int receivePort)
+const string MaxMSPNetworkManager::BODY_PARAMETER_PATHS[BODY_PARAMETER_COUNT] = {
+	OscCategories::DISTANCE + "/l-hand-l-knee",
+	OscCategories::DISTANCE + "/r-hand-r-knee",
+	OscCategories::MOVEMENT + "/l-hand",
+	OscCategories::MOVEMENT + "/r-hand",
+	OscCategories::MOVEMENT + "/l-foot",
+	OscCategories::MOVEMENT + "/r-foot",
+	OscCategories::MOVEMENT + "/l-knee",
+	OscCategories::MOVEMENT + "/r-knee",
+	"is_recording",
+	"sequence",
+	"raw_sequence"
+};
+
+MaxMSPNetworkManager::MaxMSPNetworkManager(string host, int port, int receivePort) :
+	// Some slack on top of the cap, oscpack keeps the type tags of the current message at the end of the buffer
+	bundleBuffer(Constants::MAXMSP_MAX_BUNDLE_BYTES + 64),
+	bundle(bundleBuffer.data(), bundleBuffer.size()),
+	stepEvents(64)
 {
+	this->transmitSocket = NULL;
+	this->bundleMessages = 0;
+	this->frameTimeTag = 1;
+	this->bundlesSent = 0;
+	this->messagesSent = 0;
 	this->oscHost = host;
 	this->oscPort = port;
 	this->oscReceivePort = receivePort;
+	this->receiveSocket = NULL;
+	this->sequencerStep = 0;
+	for (int i = 0; i < Constants::SEQUENCER_STEPS; i++) this->stepStartTimes[i] = 0;
+	this->sequencerStepAddress = "/" + OscCategories::SEQUENCER_STEP;
 	this->updateOscSender();
 	this->updateOscReceiver();
-	this->sequencerStep = 0;
+	this->bodyIntersectionAddress = "/" + OscCategories::BODY_INTERSECTION;
+	this->bodyPairIntersectionAddress = "/" + OscCategories::BODY_PAIR_INTERSECTION;
+	this->newBodyAddress = "/" + OscCategories::NEW_BODY;
 	ofLogNotice() << "OSC Sender sending to: " << host << ":" << port;
 }
 
@@ -27,28 +56,137 @@ void MaxMSPNetworkManager::setReceivePort(int receivePort)
 	this->updateOscReceiver();
 }
 
+MaxMSPNetworkManager::~MaxMSPNetworkManager()
+{
+	this->closeReceiveSocket();
+	delete this->transmitSocket;
+}
+
 void MaxMSPNetworkManager::updateOscSender() {
-	this->oscSender.setup(this->oscHost, this->oscPort);
+	this->flush();
+	delete this->transmitSocket;
+	this->transmitSocket = new UdpTransmitSocket(IpEndpointName(this->oscHost.c_str(), this->oscPort));
 }
 
 void MaxMSPNetworkManager::updateOscReceiver()
 {
-	this->oscReceiver.setup(this->oscReceivePort);
+	this->closeReceiveSocket();
+	try {
+		this->receiveSocket = new UdpListeningReceiveSocket(IpEndpointName(IpEndpointName::ANY_ADDRESS, this->oscReceivePort), this);
+	}
+	catch (std::exception& e) {
+		ofLogError() << "Could not listen for MaxMSP on port " << this->oscReceivePort << ": " << e.what();
+		return;
+	}
+	this->startThread();
+}
+
+// ------ Bundling ------
+
+void MaxMSPNetworkManager::beginFrame()
+{
+	// OSC time tags are NTP time: seconds since 1900 in the upper 32 bits, fractions of a second in the lower ones
+	const uint64_t NTP_UNIX_OFFSET = 2208988800ULL;
+	uint64_t micros = chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+	uint64_t seconds = micros / 1000000 + NTP_UNIX_OFFSET;
+	uint64_t fraction = ((micros % 1000000) << 32) / 1000000;
+	this->frameTimeTag = (seconds << 32) | fraction;
+}
+
+void MaxMSPNetworkManager::flush()
+{
+	if (this->bundleMessages > 0) {
+		this->bundle << osc::EndBundle;
+		this->transmitSocket->Send(this->bundle.Data(), this->bundle.Size());
+		this->bundlesSent++;
+	}
+	this->bundle.Clear();
+	this->bundleMessages = 0;
 }
 
+osc::OutboundPacketStream& MaxMSPNetworkManager::beginMessage(const string& address, int argumentCount, int argumentBytes)
+{
+	// Bundle element: size, address, type tags (',' + one per argument), arguments
+	int size = 4 + paddedSize(address.size() + 1) + paddedSize(argumentCount + 2) + argumentBytes;
+	if (this->bundleMessages > 0 && this->bundle.Size() + size > Constants::MAXMSP_MAX_BUNDLE_BYTES) this->flush();
+
+	if (this->bundleMessages == 0) this->bundle << osc::BeginBundle(this->frameTimeTag);
+	this->bundleMessages++;
+	this->messagesSent++;
+	return this->bundle << osc::BeginMessage(address.c_str());
+}
+
+int MaxMSPNetworkManager::paddedSize(int size)
+{
+	return (size + 3) & ~3;
+}
+
+int MaxMSPNetworkManager::getBundlesSent()
+{
+	return this->bundlesSent;
+}
+
+int MaxMSPNetworkManager::getMessagesSent()
+{
+	return this->messagesSent;
+}
+
+// ------ Receiving ------
+
 void MaxMSPNetworkManager::update() {
-	// Check for incoming messages from the peer
-	while (oscReceiver.hasWaitingMessages()) {
-		ofxOscMessage m;
-		oscReceiver.getNextMessage(&m);
+	// Whatever was sent outside of a frame
+	this->flush();
 
-		if (m.getAddress().compare("/" + OscCategories::SEQUENCER_STEP) == 0) {
-			this->sequencerStep = m.getArgAsInt(0);
+	StepEvent* event;
+	while ((event = this->stepEvents.front()) != NULL) {
+		this->sequencerClock.addStep(event->step, event->time);
+		this->stepEvents.pop();
+	}
+}
+
+void MaxMSPNetworkManager::closeReceiveSocket()
+{
+	if (this->receiveSocket == NULL) return;
+	this->receiveSocket->AsynchronousBreak();
+	this->waitForThread(true);
+	delete this->receiveSocket;
+	this->receiveSocket = NULL;
+}
+
+void MaxMSPNetworkManager::threadedFunction()
+{
+	// Blocks until closeReceiveSocket() breaks it, calling ProcessMessage() for every message received
+	this->receiveSocket->Run();
+}
+
+void MaxMSPNetworkManager::ProcessMessage(const osc::ReceivedMessage& m, const IpEndpointName& remoteEndpoint)
+{
+	uint64_t arrivalTime = ofGetElapsedTimeMicros();
+	try {
+		if (this->sequencerStepAddress != m.AddressPattern()) {
+			LOG_WARNING("Unrecognized message coming from OSC peer: {}", m.AddressPattern());
+			return;
+		}
+		if (m.ArgumentCount() == 0) return;
+
+		osc::ReceivedMessageArgumentIterator argument = m.ArgumentsBegin();
+		int step = argument->IsFloat() ? (int)argument->AsFloat() : (int)argument->AsInt32();
+		if (step != this->sequencerStep) {
+			const int STEPS = Constants::SEQUENCER_STEPS;
+			this->stepStartTimes[((step % STEPS) + STEPS) % STEPS] = arrivalTime;
+			this->sequencerStep = step;
 		}
-		else {
-			ofLogWarning() << "Unrecognized message coming from OSC peer!";
+
+		StepEvent* event = this->stepEvents.prepare();
+		if (event != NULL) {
+			event->step = step;
+			event->time = arrivalTime;
+			this->stepEvents.push();
 		}
 	}
+	catch (osc::Exception& e) {
+		LOG_WARNING("Malformed message coming from OSC peer: {}", e.what());
+	}
 }
 
 int MaxMSPNetworkManager::getSequencerStep()
@@ -56,75 +194,100 @@ int MaxMSPNetworkManager::getSequencerStep()
 	return this->sequencerStep;
 }
 
+float MaxMSPNetworkManager::getTimeSinceStep(int step)
+{
+	const int STEPS = Constants::SEQUENCER_STEPS;
+	uint64_t startTime = this->stepStartTimes[((step % STEPS) + STEPS) % STEPS];
+	if (startTime == 0) return -1;
+	return (ofGetElapsedTimeMicros() - startTime) / 1000.0;
+}
+
+int MaxMSPNetworkManager::getPlayingStep()
+{
+	uint64_t now = ofGetElapsedTimeMicros();
+	if (!this->sequencerClock.isRunning(now)) return this->sequencerStep;
+	const int STEPS = Constants::SEQUENCER_STEPS;
+	int64_t step = (int64_t)floor(this->sequencerClock.getStepAt(now));
+	return (((step - 1) % STEPS) + STEPS) % STEPS + 1;
+}
+
+SequencerClock* MaxMSPNetworkManager::getSequencerClock()
+{
+	return &this->sequencerClock;
+}
+
 void MaxMSPNetworkManager::sendStringMessageToAddress(string address, string message) {
-	ofxOscMessage m;
-	m.setAddress(address);
-	m.addStringArg(message);
-	this->oscSender.sendMessage(m);
-	ofLogNotice() << "Sending message: " << message << " to address: " << address;
+	this->beginMessage(address, 1, paddedSize(message.size() + 1)) << message.c_str() << osc::EndMessage;
+	LOG_NOTICE("Sending message: {} to address: {}", message, address);
 }
 
 void MaxMSPNetworkManager::sendIntMessageToAddress(string address, int message) {
-	ofxOscMessage m;
-	m.setAddress(address);
-	m.addInt32Arg(message);
-	this->oscSender.sendMessage(m);
-	ofLogNotice() << "Sending message: " << message << " to address: " << address;
+	this->beginMessage(address, 1, 4) << (osc::int32)message << osc::EndMessage;
+	LOG_NOTICE("Sending message: {} to address: {}", message, address);
 }
 
 void MaxMSPNetworkManager::sendFloatMessageToAddress(string address, float message) {
-	ofxOscMessage m;
-	m.setAddress(address);
-	m.addFloatArg(message);
-	this->oscSender.sendMessage(m);
-	ofLogNotice() << "Sending message: " << message << " to address: " << address;
+	this->beginMessage(address, 1, 4) << message << osc::EndMessage;
+	LOG_NOTICE("Sending message: {} to address: {}", message, address);
 }
 
-void MaxMSPNetworkManager::sendBodyMessage(int bodyId, string category, string parameter, int value)
+const string& MaxMSPNetworkManager::getBodyAddress(int bodyId, BodyParameter parameter)
 {
-	stringstream ss;
-	ss << "/" << bodyId << " /" << category << " /" << parameter << " " << value;
-	this->sendStringMessageToAddress(OscCategories::BODY, ss.str());
+	while (this->bodyAddresses.size() <= bodyId) {
+		const int id = this->bodyAddresses.size();
+		vector<string> addresses(BODY_PARAMETER_COUNT);
+		for (int i = 0; i < BODY_PARAMETER_COUNT; i++) {
+			addresses[i] = "/" + OscCategories::BODY + "/" + ofToString(id) + "/" + BODY_PARAMETER_PATHS[i];
+		}
+		this->bodyAddresses.push_back(addresses);
+	}
+	return this->bodyAddresses[bodyId][parameter];
+}
+
+void MaxMSPNetworkManager::sendBodyMessage(int bodyId, BodyParameter parameter, int value)
+{
+	// -1 is a body without an instrument, there's no /body/<id> for it
+	if (bodyId < 0) return;
+	this->beginMessage(this->getBodyAddress(bodyId, parameter), 1, 4) << (osc::int32)value << osc::EndMessage;
 }
 
 void MaxMSPNetworkManager::sendEnvironmentMessage(string parameter, int value)
 {
 }
 
-void MaxMSPNetworkManager::sendBodyMidiSequence(int bodyId, vector<int> midiSequence, vector<int> jointSequenceRaw)
+void MaxMSPNetworkManager::sendBodyMidiSequence(int bodyId, const vector<int>& midiSequence, const vector<int>& jointSequenceRaw)
 {
-	stringstream ss;
-	ss << "/" << bodyId;
+	if (bodyId < 0) return;
+	osc::OutboundPacketStream& m = this->beginMessage(this->getBodyAddress(bodyId, SEQUENCE), midiSequence.size(), 4 * midiSequence.size());
 	for (int i = 0; i < midiSequence.size(); i++) {
-		ss << " " << midiSequence[i];
+		m << (osc::int32)midiSequence[i];
 	}
-	this->sendStringMessageToAddress(OscCategories::BODY_SEQUENCE, ss.str());	
+	m << osc::EndMessage;
 
-	ss.str(string());
-	ss << "/" << bodyId;
+	osc::OutboundPacketStream& raw = this->beginMessage(this->getBodyAddress(bodyId, SEQUENCE_RAW), jointSequenceRaw.size(), 4 * jointSequenceRaw.size());
 	for (int i = 0; i < jointSequenceRaw.size(); i++) {
-		ss << " " << jointSequenceRaw[i];
+		raw << (osc::int32)jointSequenceRaw[i];
 	}
-	this->sendStringMessageToAddress(OscCategories::BODY_SEQUENCE_RAW, ss.str());
+	raw << osc::EndMessage;
 }
 
 void MaxMSPNetworkManager::sendIsRecording(int bodyId, bool isRecording)
 {
-	stringstream ss;
-	ss << "/" << bodyId << " " << (int)isRecording;
-	this->sendStringMessageToAddress(OscCategories::BODY_IS_RECORDING, ss.str());
+	this->sendBodyMessage(bodyId, IS_RECORDING, (int)isRecording);
 }
 
 void MaxMSPNetworkManager::sendBodyIntersection(float area, int noPolys, float duration)
 {
-	stringstream ss;
-	ss << area << " " << noPolys << " " << duration;
-	this->sendStringMessageToAddress(OscCategories::BODY_INTERSECTION, ss.str());
+	this->beginMessage(this->bodyIntersectionAddress, 3, 12) << area << (osc::int32)noPolys << duration << osc::EndMessage;
+}
+
+void MaxMSPNetworkManager::sendBodyPairIntersection(int firstBodyId, int secondBodyId, int firstSoundId, int secondSoundId, float area, int noPolys, float duration)
+{
+	this->beginMessage(this->bodyPairIntersectionAddress, 7, 28) << (osc::int32)firstBodyId << (osc::int32)secondBodyId << area << (osc::int32)noPolys << duration << (osc::int32)firstSoundId << (osc::int32)secondSoundId << osc::EndMessage;
 }
 
 void MaxMSPNetworkManager::sendNewBody(int bodyId)
 {
-	stringstream ss;
-	ss << bodyId;
-	this->sendStringMessageToAddress(OscCategories::NEW_BODY, ss.str());
+	if (bodyId < 0) return;
+	this->beginMessage(this->newBodyAddress, 1, 4) << (osc::int32)bodyId << osc::EndMessage;
 }
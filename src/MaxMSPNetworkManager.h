@@ -1,15 +1,28 @@
 #pragma once
 
 #include <string>
+#include <atomic>
 #include "ofxOsc.h"
+#include "osc/OscOutboundPacketStream.h"
+#include "osc/OscPacketListener.h"
+#include "ip/UdpSocket.h"
 #include "Constants.h"
+#include "SequencerClock.h"
+#include "SpscRing.h"
+#include "AsyncLogger.h"
 
 using namespace std;
 
-class MaxMSPNetworkManager
+// Everything sent during a frame goes out together, as one OSC bundle timetagged with the time the frame's
+// Kinect data came in: beginFrame() after the Kinect update, flush() once the frame's bodies are processed.
+// A bundle which would grow past MAXMSP_MAX_BUNDLE_BYTES is sent and a new one started, between two messages.
+// Messages from MaxMSP are read by a thread of their own as soon as they come in, and stamped with their
+// arrival time (ofGetElapsedTimeMicros()), so the sequencer's steps don't wait for the next frame.
+class MaxMSPNetworkManager : public ofThread, public osc::OscPacketListener
 {
 public: 
 	MaxMSPNetworkManager(string host, int port, int receivePort);
+	~MaxMSPNetworkManager();
 	void setHost(string host);
 	void setPort(int port);
 	void setReceivePort(int receivePort);
@@ -18,32 +31,99 @@ public:
 	void sendIntMessageToAddress(string address, int message);
 	void sendFloatMessageToAddress(string address, float message);
 
-	void sendBodyMessage(int bodyId, string category, string parameter, int value);
+	// Sound parameters of a body, sent as /body/<id>/<category>/<name> <int value>
+	enum BodyParameter {
+		DISTANCE_L_HAND_L_KNEE,
+		DISTANCE_R_HAND_R_KNEE,
+		MOVEMENT_L_HAND,
+		MOVEMENT_R_HAND,
+		MOVEMENT_L_FOOT,
+		MOVEMENT_R_FOOT,
+		MOVEMENT_L_KNEE,
+		MOVEMENT_R_KNEE,
+		IS_RECORDING,
+		SEQUENCE,
+		SEQUENCE_RAW,
+		BODY_PARAMETER_COUNT
+	};
+
+	void sendBodyMessage(int bodyId, BodyParameter parameter, int value);
 	void sendEnvironmentMessage(string parameter, int value);
 
-	void sendBodyMidiSequence(int bodyId, vector<int> midiSequence, vector<int> jointSequenceRaw);
+	// /body/<id>/sequence and /body/<id>/raw_sequence, one int argument per step
+	void sendBodyMidiSequence(int bodyId, const vector<int>& midiSequence, const vector<int>& jointSequenceRaw);
 	void sendIsRecording(int bodyId, bool isRecording);
 
 	void sendBodyIntersection(float area, int noPolys, float duration);
+	// Pairs are keyed by body ids which are the same on every site; the two sound ids
+	// (the ids of /body/<id> messages) come last: body1 body2 area noPolys duration sound1 sound2
+	void sendBodyPairIntersection(int firstBodyId, int secondBodyId, int firstSoundId, int secondSoundId, float area, int noPolys, float duration);
 
 	void sendNewBody(int bodyId);
 
+	void beginFrame();
+	void flush();
+
 	void update();
 
+	// Latest step counter value received, updated as soon as it comes in
 	int getSequencerStep();
+	// Milliseconds since step (counter value) last started, by the arrival time of its message. -1 if it never did
+	float getTimeSinceStep(int step);
+	// Step counter value playing now: predicted by the sequencer clock while it runs, the latest received otherwise
+	int getPlayingStep();
+	SequencerClock* getSequencerClock();
+	int getBundlesSent();
+	int getMessagesSent();
 
 private:
-	ofxOscSender oscSender;
-	ofxOscReceiver oscReceiver;
+	UdpTransmitSocket* transmitSocket;
 	string oscHost;
 	int oscPort;
 	int oscReceivePort;
-	int sequencerStep;
+	// Fed from stepEvents in update(), on the main thread
+	SequencerClock sequencerClock;
 
 	float lastMessageTimestamp;
 	const int MESSAGE_INTERVAL_MS = 3000;
 
 	void updateOscSender();
 	void updateOscReceiver();
+
+	// OSC address of every parameter of every body id seen so far, built once per body id
+	vector<vector<string> > bodyAddresses;
+	const string& getBodyAddress(int bodyId, BodyParameter parameter);
+	static const string BODY_PARAMETER_PATHS[BODY_PARAMETER_COUNT];
+	string bodyIntersectionAddress;
+	string bodyPairIntersectionAddress;
+	string newBodyAddress;
+
+	// Bundle being filled
+	vector<char> bundleBuffer;
+	osc::OutboundPacketStream bundle;
+	int bundleMessages;
+	osc::uint64 frameTimeTag;
+	int bundlesSent;
+	int messagesSent;
+	// Starts a message of argumentCount 4 byte arguments (argumentBytes in total) in the bundle, the caller adds
+	// the arguments and osc::EndMessage
+	osc::OutboundPacketStream& beginMessage(const string& address, int argumentCount, int argumentBytes);
+	static int paddedSize(int size);
+
+	// ------ Receive thread ------
+	UdpListeningReceiveSocket* receiveSocket;
+	string sequencerStepAddress;
+	void closeReceiveSocket();
+	void threadedFunction();
+	void ProcessMessage(const osc::ReceivedMessage& m, const IpEndpointName& remoteEndpoint);
+
+	struct StepEvent {
+		int step;
+		uint64_t time;
+	};
+	SpscRing<StepEvent> stepEvents;
+	// Written by the receive thread only. Start times are indexed by step % SEQUENCER_STEPS
+	atomic<int> sequencerStep;
+	atomic<uint64_t> stepStartTimes[Constants::SEQUENCER_STEPS];
 };
 
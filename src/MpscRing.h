@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include "ofMain.h"
+
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+using namespace std;
+
+// Fixed capacity queue from any number of producer threads to one consumer thread, without locks
+// (bounded queue with a sequence number per slot, after D. Vyukov). Producers never wait: prepare()
+// returns NULL when the ring is full. Like SpscRing, slots are built once and filled in place.
+template <typename T>
+class MpscRing {
+public:
+	// capacity has to be a power of two
+	MpscRing(int capacity) : mask(capacity - 1), enqueuePosition(0), dequeuePosition(0) {
+		this->cells = new Cell[capacity];
+		for (int i = 0; i < capacity; i++) this->cells[i].sequence.store(i, memory_order_relaxed);
+	}
+
+	~MpscRing() {
+		delete[] this->cells;
+	}
+
+	// Producer: slot to fill and its ticket for push(), NULL when the ring is full
+	T* prepare(size_t& ticket) {
+		size_t position = this->enqueuePosition.load(memory_order_relaxed);
+		while (true) {
+			Cell& cell = this->cells[position & this->mask];
+			intptr_t difference = (intptr_t)cell.sequence.load(memory_order_acquire) - (intptr_t)position;
+			if (difference == 0) {
+				if (this->enqueuePosition.compare_exchange_weak(position, position + 1, memory_order_relaxed)) break;
+			}
+			else if (difference < 0) {
+				return NULL;
+			}
+			else {
+				position = this->enqueuePosition.load(memory_order_relaxed);
+			}
+		}
+		ticket = position;
+		return &this->cells[position & this->mask].value;
+	}
+
+	void push(size_t ticket) {
+		this->cells[ticket & this->mask].sequence.store(ticket + 1, memory_order_release);
+	}
+
+	// Consumer: oldest slot, NULL when empty (or when the oldest slot is still being filled)
+	T* front() {
+		Cell& cell = this->cells[this->dequeuePosition & this->mask];
+		if (cell.sequence.load(memory_order_acquire) != this->dequeuePosition + 1) return NULL;
+		return &cell.value;
+	}
+
+	void pop() {
+		this->cells[this->dequeuePosition & this->mask].sequence.store(this->dequeuePosition + this->mask + 1, memory_order_release);
+		this->dequeuePosition++;
+	}
+
+private:
+	struct Cell {
+		atomic<size_t> sequence;
+		T value;
+	};
+
+	Cell* cells;
+	const size_t mask;
+	atomic<size_t> enqueuePosition;
+	size_t dequeuePosition;
+};
+
+#endif
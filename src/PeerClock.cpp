@@ -0,0 +1,119 @@
+#include "PeerClock.h"
+
+LatencyHistogram::LatencyHistogram(int capacity)
+{
+	this->samples.resize(capacity);
+	this->sorted.reserve(capacity);
+	this->clear();
+}
+
+void LatencyHistogram::clear()
+{
+	this->next = 0;
+	this->count = 0;
+	this->sortedDirty = true;
+}
+
+void LatencyHistogram::add(float value)
+{
+	this->samples[this->next] = value;
+	this->next = (this->next + 1) % this->samples.size();
+	this->count = min(this->count + 1, (int)this->samples.size());
+	this->sortedDirty = true;
+}
+
+int LatencyHistogram::size()
+{
+	return this->count;
+}
+
+float LatencyHistogram::getPercentile(float percentile)
+{
+	if (this->count == 0) return 0;
+
+	// Sorted once per batch of new samples, however many percentiles are asked for
+	if (this->sortedDirty) {
+		this->sorted.assign(this->samples.begin(), this->samples.begin() + this->count);
+		sort(this->sorted.begin(), this->sorted.end());
+		this->sortedDirty = false;
+	}
+
+	int index = ofClamp(round(percentile / 100 * (this->count - 1)), 0, this->count - 1);
+	return this->sorted[index];
+}
+
+PeerClock::PeerClock()
+{
+	this->clear();
+}
+
+void PeerClock::clear()
+{
+	this->exchangeCount = 0;
+	this->offset = 0;
+	this->roundTrip = 0;
+	this->roundTripHistogram.clear();
+	this->oneWayHistogram.clear();
+}
+
+int64_t PeerClock::now()
+{
+	return (int64_t)ofGetSystemTimeMicros();
+}
+
+void PeerClock::addExchange(int64_t t0, int64_t t1, int64_t t2, int64_t t3)
+{
+	int64_t roundTrip = (t3 - t0) - (t2 - t1);
+	if (roundTrip < 0) return;
+
+	int slot = this->exchangeCount % FILTER_SIZE;
+	this->roundTrips[slot] = roundTrip;
+	this->offsets[slot] = ((t1 - t0) + (t2 - t3)) / 2;
+	this->exchangeCount++;
+	this->roundTripHistogram.add(roundTrip / 1000.0);
+
+	int best = 0;
+	for (int i = 1; i < min(this->exchangeCount, (int)FILTER_SIZE); i++) {
+		if (this->roundTrips[i] < this->roundTrips[best]) best = i;
+	}
+	this->roundTrip = this->roundTrips[best];
+	this->offset = this->offsets[best];
+}
+
+void PeerClock::addMessage(uint32_t remoteMillis, uint64_t localMillis)
+{
+	if (!this->hasEstimate()) return;
+	// Both sides of the subtraction on the peer's clock, 32 bit wrap around cancels out
+	uint32_t arrival = (uint32_t)(localMillis + this->offset / 1000);
+	this->oneWayHistogram.add((int32_t)(arrival - remoteMillis));
+}
+
+bool PeerClock::hasEstimate()
+{
+	return this->exchangeCount > 0;
+}
+
+int64_t PeerClock::getOffset()
+{
+	return this->offset;
+}
+
+int64_t PeerClock::getRoundTrip()
+{
+	return this->roundTrip;
+}
+
+float PeerClock::getOneWayDelayMs()
+{
+	return this->roundTrip / 2000.0;
+}
+
+LatencyHistogram& PeerClock::getRoundTripHistogram()
+{
+	return this->roundTripHistogram;
+}
+
+LatencyHistogram& PeerClock::getOneWayHistogram()
+{
+	return this->oneWayHistogram;
+}
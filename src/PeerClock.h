@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include "ofMain.h"
+
+#ifndef PEER_CLOCK_H
+#define PEER_CLOCK_H
+
+using namespace std;
+
+// Last N samples of a delay, with percentiles over them
+class LatencyHistogram {
+public:
+	LatencyHistogram(int capacity = 256);
+	void clear();
+	void add(float value);
+	int size();
+	// percentile in [0, 100]
+	float getPercentile(float percentile);
+
+private:
+	vector<float> samples;
+	int next;
+	int count;
+	vector<float> sorted;
+	bool sortedDirty;
+};
+
+// NTP-style estimate of the peer's clock offset and of the network delay, from ping / pong exchanges:
+// t0 ping sent (local clock), t1 ping received and t2 pong sent (peer's clock), t3 pong received (local clock).
+//   round trip = (t3 - t0) - (t2 - t1)
+//   offset     = ((t1 - t0) + (t2 - t3)) / 2    (peer clock - local clock)
+// Queuing only ever adds delay, so of the last FILTER_SIZE exchanges the one with the smallest round trip
+// gives the offset and round trip estimates (min filter). All times in microseconds.
+class PeerClock {
+public:
+	PeerClock();
+	void clear();
+
+	static int64_t now();
+	void addExchange(int64_t t0, int64_t t1, int64_t t2, int64_t t3);
+	// One-way delay of a message stamped with the peer's ofGetSystemTimeMillis(), received at localMillis
+	void addMessage(uint32_t remoteMillis, uint64_t localMillis);
+
+	bool hasEstimate();
+	int64_t getOffset();
+	int64_t getRoundTrip();
+	float getOneWayDelayMs();
+
+	LatencyHistogram& getRoundTripHistogram();
+	LatencyHistogram& getOneWayHistogram();
+
+	static const int FILTER_SIZE = 8;
+
+private:
+	int64_t roundTrips[FILTER_SIZE];
+	int64_t offsets[FILTER_SIZE];
+	int exchangeCount;
+	int64_t offset;
+	int64_t roundTrip;
+
+	LatencyHistogram roundTripHistogram;
+	LatencyHistogram oneWayHistogram;
+};
+
+#endif
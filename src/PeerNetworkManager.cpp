@@ -1,82 +1,622 @@
 #include "assert.h"
 #include "PeerNetworkManager.h"
 
-PeerNetworkManager::PeerNetworkManager(string remoteIp, int remotePort, int localPort)
-{
-	this->remoteIp = remoteIp;
-	this->remotePort = remotePort;
-	this->latestTimestamp = 0;
-	this->latency = this->smoothLatency = -1;
-	this->oscSender.setup(this->remoteIp, this->remotePort);
+#ifdef TARGET_WIN32
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
 
+PeerNetworkManager::PeerNetworkManager(int siteId, string peerAddresses, int localPort, bool relayEnabled) :
+	outgoingMessages(32)
+{
+	this->siteId = siteId;
 	this->localPort = localPort;
+	this->relayEnabled = relayEnabled;
+	this->displayLatency = "N/A";
+	this->jitterBufferEnabled = true;
+	this->contourBytesSent = this->contourMessagesSent = 0;
+	this->maskBytesSent = this->maskMessagesSent = 0;
+	this->unsentMessages = 0;
+
+	this->lastPingTimestamp = 0;
+	this->lastStatsTimestamp = 0;
+	this->fragmentedMessagesSent = this->fragmentsSent = 0;
+	this->relayedMessages = 0;
+	// Not 0, so fragments left over from before a restart don't get mixed into new messages
+	this->nextMessageId = (uint32_t)ofGetSystemTimeMillis();
+	this->maskTracer.setMinAreaRadius(2);
+
+	for (int i = 0; i < Constants::MAX_PEER_SITES; i++) {
+		this->sites.push_back(new RemoteSite());
+	}
+
+	vector<string> addresses = ofSplitString(peerAddresses, ",", true, true);
+	for (auto& address : addresses) {
+		vector<string> parts = ofSplitString(address, ":", true, true);
+		int port = (parts.size() > 1) ? ofToInt(parts[1]) : Constants::PEER_PORT;
+		if (this->addLink(parts[0], port) == NULL) break;
+	}
+
 	this->oscReceiver.setup(this->localPort);
+
+	this->startThread();
+}
+
+PeerNetworkManager::~PeerNetworkManager()
+{
+	this->waitForThread(true);
+	for (auto link : this->links) delete link;
+	for (auto site : this->sites) delete site;
 }
 
 void PeerNetworkManager::update() 
 {	
-	// Check for incoming messages from the peer
+	// Frames the I/O thread decoded since the last update, site by site. Swapped, not copied
+	for (auto site : this->sites) {
+		ReceivedFrame* received;
+		while ((received = site->frames.front()) != NULL) {
+			this->storeReceivedFrame(*received);
+			site->frames.pop();
+		}
+	}
+
+	// Buffered bodies get a new interpolated frame on every update
+	if (this->jitterBufferEnabled) {
+		uint64_t now = ofGetSystemTimeMillis();
+		for (auto it = this->jitterBuffers.begin(); it != this->jitterBuffers.end(); ++it) {
+			if (it->second.sample(now, this->bodyFrames[it->first])) this->newBodyData[it->first] = true;
+		}
+	}
+
+	if (this->linkStatsSlot.update()) this->linkStats = this->linkStatsSlot.get();
+	if (ofGetFrameNum() % 40 == 0) this->updateDisplayLatency();
+}
+
+void PeerNetworkManager::storeReceivedFrame(ReceivedFrame& received)
+{
+	int id = received.frame.index;
+	if (this->dataTimestamps.find(id) == this->dataTimestamps.end()) {
+		this->bodyIds.insert(lower_bound(this->bodyIds.begin(), this->bodyIds.end(), id), id);
+	}
+
+	if (this->jitterBufferEnabled) {
+		BodyJitterBuffer& jitterBuffer = this->jitterBuffers[id];
+		if (!this->isBodyActive(id)) jitterBuffer.clear();
+		jitterBuffer.push(received.frame, received.arrivalTime);
+	}
+	else {
+		swap(this->bodyFrames[id], received.frame);
+		this->newBodyData[id] = true;
+	}
+	this->dataTimestamps[id] = received.arrivalTime;
+}
+
+void PeerNetworkManager::sendBodyData(int index, const BodyFrame& frame)
+{
+	// Encoded here, once for all peers. The codec's keyframe state stays on this thread.
+	// Dropped if the I/O thread is that far behind
+	OutgoingMessage* message = this->outgoingMessages.prepare();
+	if (message == NULL) {
+		this->unsentMessages++;
+		return;
+	}
+	message->index = index;
+	int bytes = this->encoder.encode(frame, message->data);
+	this->outgoingMessages.push();
+
+	if (frame.hasMask) {
+		this->maskBytesSent += bytes;
+		this->maskMessagesSent++;
+	}
+	else {
+		this->contourBytesSent += bytes;
+		this->contourMessagesSent++;
+	}
+}
+
+const vector<int>& PeerNetworkManager::getBodyIds()
+{
+	return this->bodyIds;
+}
+
+const BodyFrame* PeerNetworkManager::getBodyData(int id)
+{
+	auto it = this->bodyFrames.find(id);
+	if (it == this->bodyFrames.end()) return NULL;
+	return &it->second;
+}
+
+void PeerNetworkManager::setJitterBufferEnabled(bool jitterBufferEnabled)
+{
+	if (jitterBufferEnabled == this->jitterBufferEnabled) return;
+	this->jitterBufferEnabled = jitterBufferEnabled;
+	for (auto it = this->jitterBuffers.begin(); it != this->jitterBuffers.end(); ++it) {
+		it->second.clear();
+	}
+}
+
+const BodyFrame* PeerNetworkManager::takeNewBodyData(int id)
+{
+	auto it = this->newBodyData.find(id);
+	if (it == this->newBodyData.end() || !it->second) return NULL;
+	it->second = false;
+	return this->getBodyData(id);
+}
+
+// ------ I/O thread ------
+
+void PeerNetworkManager::threadedFunction()
+{
+#ifdef TARGET_WIN32
+	// Windows sleeps in 15.6ms ticks by default, the loop below needs 1ms ones
+	timeBeginPeriod(1);
+#endif
+
+	while (this->isThreadRunning()) {
+		this->receiveMessages();
+		this->sendMessages();
+
+		uint64_t now = ofGetSystemTimeMillis();
+		for (auto site : this->sites) site->reassembler.expire(now);
+
+		// Pings also tell the peer who we are & where to answer. They carry the index of the link they go out on,
+		// which the pong sends back: that's how a link learns its site, whatever address the answer comes from
+		if (now - this->lastPingTimestamp >= Constants::PEER_PING_INTERVAL_MS) {
+			for (int i = 0; i < this->links.size(); i++) {
+				PeerLink* link = this->links[i];
+				if (link->siteId == this->siteId || !this->isPrimaryLink(link)) continue;
+				ofxOscMessage ping;
+				ping.setAddress(OscCategories::PEER_PING);
+				ping.addInt32Arg(this->siteId);
+				ping.addInt32Arg(this->localPort);
+				ping.addInt64Arg(PeerClock::now());
+				ping.addInt32Arg(i);
+				link->sender.sendMessage(ping);
+			}
+			this->lastPingTimestamp = now;
+		}
+
+		if (now - this->lastStatsTimestamp >= 100) {
+			this->publishLinkStats();
+			this->lastStatsTimestamp = now;
+		}
+
+		// ofxOscReceiver has no blocking read, a millisecond of latency at most
+		this->sleep(1);
+	}
+
+#ifdef TARGET_WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+void PeerNetworkManager::receiveMessages()
+{
+	// Check for incoming messages from the peers
+	int count = 0;
 	while (oscReceiver.hasWaitingMessages()) {
-		ofxOscMessage m;
-		oscReceiver.getNextMessage(&m);
+		if (count == this->incomingMessages.size()) this->incomingMessages.push_back(IncomingMessage());
+		oscReceiver.getNextMessage(&this->incomingMessages[count].message);
+		this->incomingMessages[count].receivedAt = PeerClock::now();
+		count++;
+	}
+
+	for (int i = 0; i < count; i++) {
+		ofxOscMessage& m = this->incomingMessages[i].message;
+		const int64_t receivedAt = this->incomingMessages[i].receivedAt;
+
+		// Every message starts with the id of the site it comes from (for bodies, the site which captured them)
+		if (m.getNumArgs() == 0) continue;
+		int originId = m.getArgAsInt(0);
+		if (originId < 0 || originId >= Constants::MAX_PEER_SITES) continue;
+		if (originId == this->siteId) {
+			// Our own ping: the link it went out on is us, nothing is sent there anymore.
+			// It may come back from another address than the one listed (localhost, another interface)
+			if (m.getAddress().compare(OscCategories::PEER_PING) == 0 && m.getNumArgs() > 3) {
+				int linkIndex = m.getArgAsInt(3);
+				if (linkIndex >= 0 && linkIndex < this->links.size()) this->links[linkIndex]->siteId = this->siteId;
+			}
+			continue;
+		}
+		RemoteSite& site = *this->sites[originId];
 
 		if (m.getAddress().compare(OscCategories::REMOTE_BODY_DATA) == 0) {
-			int bodyIndex = m.getArgAsInt(0);
-			string data = m.getArgAsString(1);
-			this->serializedData[bodyIndex] = data;
-			int timestamp = ofGetSystemTimeMillis();
-			this->dataTimestamps[bodyIndex] = timestamp;
-
-			if (this->latestTimestamp == 0) {
-				this->latency = this->smoothLatency = this->displayLatency = 500;
-			} else {
-				this->latency = (timestamp - this->latestTimestamp);
-				this->smoothLatency = 0.9 * this->smoothLatency + 0.1 * this->latency;
+			int bodyIndex = m.getArgAsInt(1);
+			ofBuffer data = m.getArgAsBlob(2);
+			site.bytesReceived += data.size();
+			// Only messages seen for the first time are passed on: two hubs linked to each other would bounce the rest forever
+			bool isNew = this->receiveBodyData(originId, bodyIndex, data);
+			if (this->relayEnabled && isNew) this->sendToPeers(m, originId);
+		} else if (m.getAddress().compare(OscCategories::REMOTE_BODY_FRAGMENT) == 0) {
+			int bodyIndex = m.getArgAsInt(1);
+			ofBuffer fragment = m.getArgAsBlob(5);
+			site.bytesReceived += fragment.size();
+			FragmentReassembler::Result result = site.reassembler.add(m.getArgAsInt(2), m.getArgAsInt(3), m.getArgAsInt(4), fragment, ofGetSystemTimeMillis(), this->reassembledData);
+			if (result == FragmentReassembler::COMPLETED) {
+				this->receiveBodyData(originId, bodyIndex, this->reassembledData);
+			}
+			// Fragments are passed on as they come, the other sites put them together themselves. Duplicates aren't
+			if (this->relayEnabled && result != FragmentReassembler::DROPPED) this->sendToPeers(m, originId);
+		} else if (m.getAddress().compare(OscCategories::PEER_PING) == 0) {
+			if (m.getNumArgs() < 4) continue;
+			// Answered right away. Time between receiving & answering is taken out of the round trip on the other side
+			string ip = m.getRemoteHost();
+			int port = m.getArgAsInt(1);
+			PeerLink* link = NULL;
+			for (auto candidate : this->links) {
+				if (candidate->ip == ip && candidate->port == port) link = candidate;
 			}
+			// A site we already have under another address keeps its link, otherwise it's a new peer from now on
+			if (link == NULL) link = this->findLink(originId);
+			if (link == NULL) link = this->addLink(ip, port);
+			if (link == NULL) continue;
+			link->siteId = originId;
 
-			this->latestTimestamp = timestamp;
+			ofxOscMessage pong;
+			pong.setAddress(OscCategories::PEER_PONG);
+			pong.addInt32Arg(this->siteId);
+			pong.addInt64Arg(m.getArgAsInt64(2));
+			pong.addInt64Arg(receivedAt);
+			pong.addInt64Arg(PeerClock::now());
+			pong.addInt32Arg(m.getArgAsInt(3));
+			link->sender.sendMessage(pong);
+		} else if (m.getAddress().compare(OscCategories::PEER_PONG) == 0) {
+			if (m.getNumArgs() < 5) continue;
+			// Sent back on the link the ping went out on
+			int linkIndex = m.getArgAsInt(4);
+			if (linkIndex < 0 || linkIndex >= this->links.size()) continue;
+			PeerLink* link = this->links[linkIndex];
+			link->siteId = originId;
+			link->clock.addExchange(m.getArgAsInt64(1), m.getArgAsInt64(2), m.getArgAsInt64(3), receivedAt);
 		} else {
-			ofLogWarning() << "Unrecognized message coming from OSC peer!";
+			LOG_WARNING("Unrecognized message coming from OSC peer: {}", m.getAddress());
+			continue;
+		}
+
+		site.latestTimestamp = ofGetSystemTimeMillis();
+	}
+}
+
+void PeerNetworkManager::sendMessages()
+{
+	OutgoingMessage* message;
+	while ((message = this->outgoingMessages.front()) != NULL) {
+		const int index = message->index;
+		const ofBuffer& data = message->data;
+		const int bytes = data.size();
+
+		if (bytes <= Constants::PEER_MAX_FRAGMENT_BYTES) {
+			ofxOscMessage m;
+			m.setAddress(OscCategories::REMOTE_BODY_DATA);
+			m.addInt32Arg(this->siteId);
+			m.addInt32Arg(index);
+			m.addBlobArg(data);
+			this->sendToPeers(m, this->siteId);
+		}
+		else {
+			// Too large for one datagram: sent in pieces, each small enough not to be fragmented by IP
+			int fragmentCount = (bytes + Constants::PEER_MAX_FRAGMENT_BYTES - 1) / Constants::PEER_MAX_FRAGMENT_BYTES;
+			if (fragmentCount > FragmentReassembler::MAX_FRAGMENTS) {
+				LOG_WARNING("Body message of {} bytes is too large to send to the peers", bytes);
+				fragmentCount = 0;
+			}
+			uint32_t messageId = this->nextMessageId++;
+			for (int i = 0; i < fragmentCount; i++) {
+				int offset = i * Constants::PEER_MAX_FRAGMENT_BYTES;
+				this->fragmentBuffer.set(data.getData() + offset, min(bytes - offset, Constants::PEER_MAX_FRAGMENT_BYTES));
+				ofxOscMessage m;
+				m.setAddress(OscCategories::REMOTE_BODY_FRAGMENT);
+				m.addInt32Arg(this->siteId);
+				m.addInt32Arg(index);
+				m.addInt32Arg(messageId);
+				m.addInt32Arg(i);
+				m.addInt32Arg(fragmentCount);
+				m.addBlobArg(this->fragmentBuffer);
+				this->sendToPeers(m, this->siteId);
+			}
+			if (fragmentCount > 0) {
+				this->fragmentedMessagesSent++;
+				this->fragmentsSent += fragmentCount;
+			}
 		}
+
+		this->outgoingMessages.pop();
+	}
+}
+
+void PeerNetworkManager::sendToPeers(ofxOscMessage& m, int skipSiteId)
+{
+	const bool isRelay = skipSiteId != this->siteId;
+	for (auto link : this->links) {
+		if (link->siteId == this->siteId || link->siteId == skipSiteId || !this->isPrimaryLink(link)) continue;
+		// Relayed only to sites we know are there, our own bodies go to every address we have
+		if (isRelay && link->siteId < 0) continue;
+		link->sender.sendMessage(m);
+		if (isRelay) this->relayedMessages++;
 	}
+}
+
+PeerNetworkManager::PeerLink* PeerNetworkManager::addLink(string ip, int port)
+{
+	if (this->links.size() >= Constants::MAX_PEER_SITES) {
+		LOG_WARNING("Too many peers, ignoring {}:{}", ip, port);
+		return NULL;
+	}
+	PeerLink* link = new PeerLink();
+	link->ip = ip;
+	link->port = port;
+	link->siteId = -1;
+	link->sender.setup(ip, port);
+	this->links.push_back(link);
+	return link;
+}
+
+PeerNetworkManager::PeerLink* PeerNetworkManager::findLink(int siteId)
+{
+	for (auto link : this->links) {
+		if (link->siteId == siteId) return link;
+	}
+	return NULL;
+}
 
-	if (ofGetFrameNum() % 40 == 0) this->displayLatency = this->smoothLatency;
+// A site listed under two addresses (or listed & pinging us from another one) ends up with two links:
+// only the first one is used
+bool PeerNetworkManager::isPrimaryLink(PeerLink* link)
+{
+	return link->siteId < 0 || this->findLink(link->siteId) == link;
+}
+
+bool PeerNetworkManager::receiveBodyData(int originId, int bodyIndex, const ofBuffer& data)
+{
+	RemoteSite& site = *this->sites[originId];
+	uint64_t now = ofGetSystemTimeMillis();
+	if (bodyIndex < 0 || bodyIndex >= SITE_BODY_IDS) return false;
+
+	// Malformed messages are left to the decoder, which counts them, and aren't passed on
+	int messageIndex;
+	uint32_t sequence;
+	const bool isWellFormed = BodyDataCodec::peekSequence(data, messageIndex, sequence);
+	const bool isFirstSeen = isWellFormed && this->markSeen(site, bodyIndex, sequence);
+	const bool isNew = !isWellFormed || (isFirstSeen && this->isNewSequence(site, bodyIndex, sequence));
+	if (!isNew) site.staleMessages++;
 
+	// Decoded right away, every keyframe has to reach the codec even if a newer message follows.
+	// Only a decoded message moves the body's sequence on
+	if (isNew && site.decoder.decode(data, this->decodedFrame)) {
+		site.sequences[bodyIndex] = this->decodedFrame.sequence;
+		// One-way delay only for sites we have a clock for, not the ones relayed to us
+		PeerLink* link = this->findLink(originId);
+		if (link != NULL) link->clock.addMessage(this->decodedFrame.captureTime, now);
+		if (this->decodedFrame.hasMask) this->traceMaskContour(this->decodedFrame);
+
+		// Handed over to the main thread. If it fell that far behind, the frame is lost
+		ReceivedFrame* received = site.frames.prepare();
+		if (received == NULL) {
+			site.droppedFrames++;
+		}
+		else {
+			this->decodedFrame.index = originId * SITE_BODY_IDS + bodyIndex;
+			swap(received->frame, this->decodedFrame);
+			received->arrivalTime = now;
+			site.frames.push();
+		}
+	}
+	site.timestamps[bodyIndex] = now;
+	return isFirstSeen;
 }
 
-void PeerNetworkManager::sendBodyData(int index, string data)
+bool PeerNetworkManager::isNewSequence(RemoteSite& site, int index, uint32_t sequence)
 {
-	ofxOscMessage m;
-	m.setAddress(OscCategories::REMOTE_BODY_DATA);
-	m.addInt32Arg(index);
-	m.addStringArg(data);
-	this->oscSender.sendMessage(m);
+	// A body which timed out starts over, the peer may have restarted in the meantime
+	auto it = site.sequences.find(index);
+	if (it == site.sequences.end()) return true;
+	if (ofGetSystemTimeMillis() - site.timestamps[index] >= Constants::NETWORK_TRAFFIC_MAX_LATENCY_MS) return true;
+	return (int32_t)(sequence - it->second) > 0;
 }
 
-string PeerNetworkManager::getBodyData(int index)
+bool PeerNetworkManager::markSeen(RemoteSite& site, int index, uint32_t sequence)
 {
-	if (this->serializedData.find(index) == this->serializedData.end()) {
-		return "";
+	const uint64_t key = ((uint64_t)index << 32) | sequence;
+
+	// Same as for sequences: after a timeout the peer may have restarted, with the same sequence numbers again
+	auto timestamp = site.timestamps.find(index);
+	if (timestamp != site.timestamps.end() && ofGetSystemTimeMillis() - timestamp->second >= Constants::NETWORK_TRAFFIC_MAX_LATENCY_MS) {
+		for (int i = 0; i < RemoteSite::SEEN_MESSAGES; i++) {
+			if ((site.seenMessages[i] >> 32) == (uint64_t)index) site.seenMessages[i] = RemoteSite::NOT_SEEN;
+		}
 	}
-	else {
-		return this->serializedData[index];
+
+	for (int i = 0; i < RemoteSite::SEEN_MESSAGES; i++) {
+		if (site.seenMessages[i] == key) return false;
+	}
+	site.seenMessages[site.seenCount % RemoteSite::SEEN_MESSAGES] = key;
+	site.seenCount++;
+	return true;
+}
+
+void PeerNetworkManager::publishLinkStats()
+{
+	const float percentiles[3] = { 50, 95, 99 };
+	LinkStats& stats = this->linkStatsSlot.getBack();
+
+	for (int i = 0; i < Constants::MAX_PEER_SITES; i++) {
+		RemoteSite& site = *this->sites[i];
+		SiteStats& siteStats = stats.sites[i];
+		siteStats.latestTimestamp = site.latestTimestamp;
+		siteStats.bytesReceived = site.bytesReceived;
+		siteStats.staleMessages = site.staleMessages;
+		siteStats.droppedFrames = site.droppedFrames;
+		siteStats.decodeErrors = site.decoder.getDecodeErrors();
+		siteStats.missingKeyframes = site.decoder.getMissingKeyframes();
+		siteStats.fragmentsReceived = site.reassembler.getFragmentsReceived();
+		siteStats.messagesReassembled = site.reassembler.getMessagesReassembled();
+		siteStats.messagesLost = site.reassembler.getMessagesLost();
+		siteStats.duplicateFragments = site.reassembler.getDuplicateFragments();
+		siteStats.malformedFragments = site.reassembler.getMalformedFragments();
+
+		PeerLink* link = this->findLink(i);
+		siteStats.isDirect = link != NULL;
+		siteStats.hasClockEstimate = link != NULL && link->clock.hasEstimate();
+		siteStats.oneWaySamples = 0;
+		if (!siteStats.hasClockEstimate) continue;
+
+		siteStats.clockOffset = link->clock.getOffset();
+		siteStats.roundTrip = link->clock.getRoundTrip();
+		LatencyHistogram& roundTrips = link->clock.getRoundTripHistogram();
+		LatencyHistogram& oneWay = link->clock.getOneWayHistogram();
+		siteStats.oneWaySamples = oneWay.size();
+		for (int k = 0; k < 3; k++) {
+			siteStats.roundTripPercentiles[k] = roundTrips.getPercentile(percentiles[k]);
+			siteStats.oneWayPercentiles[k] = oneWay.getPercentile(percentiles[k]);
+		}
 	}
+
+	stats.fragmentedMessagesSent = this->fragmentedMessagesSent;
+	stats.fragmentsSent = this->fragmentsSent;
+	stats.relayedMessages = this->relayedMessages;
+	this->linkStatsSlot.publish();
 }
 
-bool PeerNetworkManager::isBodyActive(int index)
+void PeerNetworkManager::traceMaskContour(BodyFrame& frame)
 {
-	if (this->dataTimestamps.find(index) == this->dataTimestamps.end())
+	// Body cells get label 0, inside a background border so the silhouette is always closed
+	const int width = frame.maskWidth + 2;
+	this->maskPixels.allocate(width, frame.maskHeight + 2, OF_PIXELS_GRAY);
+	this->maskPixels.set(BodyContourTracer::BACKGROUND_LABEL);
+	unsigned char* pixels = this->maskPixels.getData();
+	for (int row = 0; row < frame.maskHeight; row++) {
+		const uint8_t* cells = frame.mask.data() + row * frame.maskWidth;
+		unsigned char* target = pixels + (row + 1) * width + 1;
+		for (int column = 0; column < frame.maskWidth; column++) {
+			if (cells[column]) target[column] = 0;
+		}
+	}
+
+	this->maskTracer.findContours(this->maskPixels);
+	frame.contour.clear();
+	if (!this->maskTracer.hasContour(0)) return;
+
+	// Back to depth pixels, at the pixel each cell was sampled from
+	const ContourBuffer& traced = this->maskTracer.getLargestContour(0);
+	const float* tracedX = traced.getX();
+	const float* tracedY = traced.getY();
+	const float offset = frame.maskScale / 2;
+	frame.contour.resize(traced.size());
+	float* x = frame.contour.getX();
+	float* y = frame.contour.getY();
+	for (int i = 0; i < traced.size(); i++) {
+		x[i] = frame.maskX + (tracedX[i] - 1) * frame.maskScale + offset;
+		y[i] = frame.maskY + (tracedY[i] - 1) * frame.maskScale + offset;
+	}
+}
+
+// ------ Status ------
+
+bool PeerNetworkManager::isBodyActive(int id)
+{
+	auto it = this->dataTimestamps.find(id);
+	if (it == this->dataTimestamps.end())
 		return false;
-	return (ofGetSystemTimeMillis() - this->dataTimestamps[index] < Constants::NETWORK_TRAFFIC_MAX_LATENCY_MS);
+	return (ofGetSystemTimeMillis() - it->second < Constants::NETWORK_TRAFFIC_MAX_LATENCY_MS);
+}
+
+int PeerNetworkManager::getSiteId()
+{
+	return this->siteId;
+}
+
+int PeerNetworkManager::getConnectedPeerCount()
+{
+	int count = 0;
+	for (int i = 0; i < Constants::MAX_PEER_SITES; i++) {
+		if (ofGetSystemTimeMillis() - this->linkStats.sites[i].latestTimestamp < Constants::NETWORK_TRAFFIC_MAX_LATENCY_MS) count++;
+	}
+	return count;
 }
 
 bool PeerNetworkManager::isConnected() {
-	return (ofGetSystemTimeMillis() - this->latestTimestamp < Constants::NETWORK_TRAFFIC_MAX_LATENCY_MS);
+	return this->getConnectedPeerCount() > 0;
 }
 
 string PeerNetworkManager::getLatency() {
 	if (!this->isConnected()) return "N/A";
+	return this->displayLatency;
+}
+
+void PeerNetworkManager::updateDisplayLatency() {
+	// The slowest connected site we have a clock for
+	const SiteStats* slowest = NULL;
+	int slowestId = -1;
+	float slowestDelay = 0;
+	for (int i = 0; i < Constants::MAX_PEER_SITES; i++) {
+		const SiteStats& site = this->linkStats.sites[i];
+		if (!site.hasClockEstimate || ofGetSystemTimeMillis() - site.latestTimestamp >= Constants::NETWORK_TRAFFIC_MAX_LATENCY_MS) continue;
+		float delay = (site.oneWaySamples > 0) ? site.oneWayPercentiles[0] : site.roundTrip / 2000.0;
+		if (slowest == NULL || delay > slowestDelay) {
+			slowest = &site;
+			slowestId = i;
+			slowestDelay = delay;
+		}
+	}
+
+	if (slowest == NULL) {
+		this->displayLatency = "measuring...";
+		return;
+	}
+
+	// One-way delay of body data, from capture on the peer to arrival here. Falls back to half the round trip
 	stringstream ss;
-	ss << ((int)this->displayLatency) << "ms";
+	if (slowest->oneWaySamples > 0) {
+		const float* oneWay = slowest->oneWayPercentiles;
+		ss << (int)oneWay[0] << "ms (p95 " << (int)oneWay[1] << ", p99 " << (int)oneWay[2] << ")";
+	}
+	else {
+		ss << (int)slowestDelay << "ms";
+	}
+	if (this->getConnectedPeerCount() > 1) ss << " site " << slowestId;
+	this->displayLatency = ss.str();
+}
+
+string PeerNetworkManager::getTrafficStats() {
+	const LinkStats& link = this->linkStats;
+	stringstream ss;
+	ss << "site " << this->siteId << (this->relayEnabled ? " (hub)" : "");
+	ss << ", sent " << (this->contourBytesSent + this->maskBytesSent) / 1024 << "kB";
+	if (this->contourMessagesSent > 0) ss << ", contour " << this->contourBytesSent / this->contourMessagesSent << "B/body";
+	if (this->maskMessagesSent > 0) ss << ", mask " << this->maskBytesSent / this->maskMessagesSent << "B/body";
+	ss << ", keyframes / deltas " << this->encoder.getKeyframeCount() << " / " << this->encoder.getDeltaCount();
+	if (this->unsentMessages > 0) ss << ", send queue overflows " << this->unsentMessages;
+	if (link.fragmentedMessagesSent > 0) ss << ", fragmented " << link.fragmentedMessagesSent << " (" << link.fragmentsSent << " fragments)";
+	if (link.relayedMessages > 0) ss << ", relayed " << link.relayedMessages;
+	if (this->jitterBufferEnabled) {
+		float playoutDelay = 0, jitter = 0;
+		int lateFrames = 0;
+		for (auto it = this->jitterBuffers.begin(); it != this->jitterBuffers.end(); ++it) {
+			if (it->second.isEmpty()) continue;
+			playoutDelay = max(playoutDelay, it->second.getPlayoutDelay());
+			jitter = max(jitter, it->second.getJitter());
+			lateFrames += it->second.getLateFrames();
+		}
+		ss << ", playout " << (int)playoutDelay << "ms (jitter " << (int)jitter << "ms, late " << lateFrames << ")";
+	}
+
+	for (int i = 0; i < Constants::MAX_PEER_SITES; i++) {
+		const SiteStats& site = link.sites[i];
+		if (site.latestTimestamp == 0) continue;
+		ss << endl << "  site " << i << (site.isDirect ? "" : " (relayed)");
+		ss << ": received " << site.bytesReceived / 1024 << "kB";
+		ss << ", stale " << site.staleMessages;
+		if (site.droppedFrames > 0) ss << ", receive queue overflows " << site.droppedFrames;
+		if (site.fragmentsReceived > 0) {
+			ss << ", reassembled " << site.messagesReassembled << " / lost " << site.messagesLost;
+			ss << " (duplicate " << site.duplicateFragments << ", malformed " << site.malformedFragments << ")";
+		}
+		if (site.hasClockEstimate) {
+			ss << ", rtt " << site.roundTrip / 1000.0 << "ms (p50 " << site.roundTripPercentiles[0];
+			ss << " / p95 " << site.roundTripPercentiles[1] << " / p99 " << site.roundTripPercentiles[2] << ")";
+			ss << ", clock offset " << site.clockOffset / 1000 << "ms";
+		}
+		ss << ", decode errors " << site.decodeErrors << ", missing keyframes " << site.missingKeyframes;
+	}
 	return ss.str();
 }
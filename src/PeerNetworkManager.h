@@ -3,40 +3,193 @@
 #include "ofMain.h"
 #include "ofxOsc.h"
 #include "Constants.h"
+#include "BodyDataCodec.h"
+#include "BodyContourTracer.h"
+#include "BodyJitterBuffer.h"
+#include "PeerClock.h"
+#include "FragmentReassembler.h"
+#include "SpscRing.h"
+#include "LatestValueSlot.h"
+#include "AsyncLogger.h"
 
 #ifndef NETWORK_MANAGER_H
 #define NETWORK_MANAGER_H
 
 using namespace std;
 
-class PeerNetworkManager {
+// Session with the other sites of a performance, up to MAX_PEER_SITES of them.
+// Every site has an id, unique in the session, and sends its bodies to every peer it knows of. A peer which
+// pings us is known from then on, so a site only has to list some of the others: a hub site with relaying
+// enabled forwards every body message to its other peers, and the sites around it only need the hub's address.
+// Remote bodies are numbered per site: body i of site s is body s * SITE_BODY_IDS + i here.
+//
+// The sockets are served by a thread of their own: it receives, reassembles, decodes (and traces masks),
+// answers pings, relays and sends. The main thread only encodes outgoing frames (once, whatever the number
+// of peers) and swaps frames in and out of lock-free rings, so a burst of packets doesn't cost frame time.
+class PeerNetworkManager : public ofThread {
 public:
-	PeerNetworkManager(string remoteIp, int remotePort, int localPort);
+	// peerAddresses: "ip:port, ip:port, ...". Our own address may be in there, it's ignored
+	PeerNetworkManager(int siteId, string peerAddresses, int localPort, bool relayEnabled);
+	~PeerNetworkManager();
 	
 	void update();
+	// Play remote bodies back through a jitter buffer (interpolated, slightly delayed) instead of as they come in
+	void setJitterBufferEnabled(bool jitterBufferEnabled);
 
-	void sendBodyData(int index, string data);
-	string getBodyData(int index);
-	bool isBodyActive(int index);
+	void sendBodyData(int index, const BodyFrame& frame);
+	// Ids of every remote body received so far, in increasing order
+	const vector<int>& getBodyIds();
+	// Latest decoded frame of a remote body, NULL if none was received yet
+	const BodyFrame* getBodyData(int id);
+	// Same frame, but only once per sequence number: NULL if nothing new arrived since the last call
+	const BodyFrame* takeNewBodyData(int id);
+	bool isBodyActive(int id);
 
+	int getSiteId();
+	// Sites we heard from recently
+	int getConnectedPeerCount();
 	bool isConnected();
+	// One-way delay of the body data of the slowest peer (median, p95 & p99)
 	string getLatency();
+	// One line per peer
+	string getTrafficStats();
+
+	static const int SITE_BODY_IDS = Constants::BODY_RECORDINGS_ID_OFFSET + Constants::MAX_BODY_RECORDINGS;
 
 private:
-	bool isThisServer;
-	string remoteIp;
-	int remotePort;
+	int siteId;
 	int localPort;
-	map<int, string> serializedData;
-	map<int, int> dataTimestamps;
+	bool relayEnabled;
+
+	// Decoded on the I/O thread, in order of arrival
+	struct ReceivedFrame {
+		BodyFrame frame;
+		uint64_t arrivalTime;
+	};
+	// Encoded on the main thread
+	struct OutgoingMessage {
+		int index;
+		ofBuffer data;
+	};
+
+	// What the I/O thread knows about every site, copied out for the stats every few frames
+	struct SiteStats {
+		uint64_t latestTimestamp;
+		int bytesReceived;
+		int staleMessages;
+		int droppedFrames;
+		int decodeErrors, missingKeyframes;
+		int fragmentsReceived, messagesReassembled, messagesLost, duplicateFragments, malformedFragments;
+		bool isDirect;
+		bool hasClockEstimate;
+		int64_t clockOffset, roundTrip;
+		float roundTripPercentiles[3];
+		int oneWaySamples;
+		float oneWayPercentiles[3];
+	};
+	struct LinkStats {
+		SiteStats sites[Constants::MAX_PEER_SITES];
+		int fragmentedMessagesSent, fragmentsSent;
+		int relayedMessages;
+		LinkStats() { memset(this, 0, sizeof(LinkStats)); }
+	};
+
+	// A site we send to directly
+	struct PeerLink {
+		string ip;
+		int port;
+		ofxOscSender sender;
+		// Learned from its pings & pongs, -1 until then. Our own site id for our own address
+		int siteId;
+		PeerClock clock;
+	};
+
+	// A site we receive bodies from, directly or through a hub. Indexed by site id
+	struct RemoteSite {
+		// Each site has its own keyframes and fragment ids
+		BodyDataCodec decoder;
+		FragmentReassembler reassembler;
+		// Last sequence number decoded & last arrival of every body, for dropping stale messages
+		map<int, uint32_t> sequences;
+		map<int, uint64_t> timestamps;
+		// (body index << 32 | sequence) of the latest messages received, to take & relay every message once
+		// however many ways it comes in. Apart from sequences, so a message which didn't decode yet
+		// (a delta ahead of its late keyframe) doesn't make the keyframe look stale
+		static const int SEEN_MESSAGES = 256;
+		static const uint64_t NOT_SEEN = ~0ULL;
+		uint64_t seenMessages[SEEN_MESSAGES];
+		uint32_t seenCount;
+		// Per site, so a site flooding us doesn't push the others' frames out
+		SpscRing<ReceivedFrame> frames;
+		uint64_t latestTimestamp;
+		int bytesReceived;
+		int staleMessages;
+		int droppedFrames;
+		RemoteSite() : seenCount(0), frames(32), latestTimestamp(0), bytesReceived(0), staleMessages(0), droppedFrames(0) {
+			for (int i = 0; i < SEEN_MESSAGES; i++) this->seenMessages[i] = NOT_SEEN;
+		}
+	};
 
-	ofxOscSender oscSender;
+	vector<RemoteSite*> sites;
+	SpscRing<OutgoingMessage> outgoingMessages;
+	LatestValueSlot<LinkStats> linkStatsSlot;
+
+	// ------ Main thread ------
+	map<int, BodyFrame> bodyFrames;
+	map<int, bool> newBodyData;
+	map<int, BodyJitterBuffer> jitterBuffers;
+	map<int, uint64_t> dataTimestamps;
+	vector<int> bodyIds;
+	bool jitterBufferEnabled;
+	BodyDataCodec encoder;
+	// Sent bytes & messages per transport mode, to compare them
+	int contourBytesSent, contourMessagesSent;
+	int maskBytesSent, maskMessagesSent;
+	int unsentMessages;
+	LinkStats linkStats;
+	string displayLatency;
+	void storeReceivedFrame(ReceivedFrame& received);
+	void updateDisplayLatency();
+
+	// ------ I/O thread ------
+	void threadedFunction();
+	void receiveMessages();
+	void sendMessages();
+	void sendToPeers(ofxOscMessage& m, int skipSiteId);
+	// True when the message is one we hadn't seen yet, the only ones a hub passes on
+	bool receiveBodyData(int originId, int bodyIndex, const ofBuffer& data);
+	bool isNewSequence(RemoteSite& site, int index, uint32_t sequence);
+	bool markSeen(RemoteSite& site, int index, uint32_t sequence);
+	PeerLink* addLink(string ip, int port);
+	PeerLink* findLink(int siteId);
+	bool isPrimaryLink(PeerLink* link);
+	void publishLinkStats();
+
+	vector<PeerLink*> links;
 	ofxOscReceiver oscReceiver;
+	// Everything waiting on the receiver is taken off first, stamped (PeerClock) as it's taken,
+	// so decoding the ones before doesn't add to a ping's times. Kept between rounds
+	struct IncomingMessage {
+		ofxOscMessage message;
+		int64_t receivedAt;
+	};
+	vector<IncomingMessage> incomingMessages;
+	BodyFrame decodedFrame;
+
+	// Body messages over PEER_MAX_FRAGMENT_BYTES go out in fragments
+	uint32_t nextMessageId;
+	ofBuffer fragmentBuffer;
+	int fragmentedMessagesSent, fragmentsSent;
+	ofBuffer reassembledData;
+	int relayedMessages;
+
+	// Contours of bodies received as masks are traced back here
+	BodyContourTracer maskTracer;
+	ofPixels maskPixels;
+	void traceMaskContour(BodyFrame& frame);
 
-	int latestTimestamp;
-	float smoothLatency;
-	float latency;
-	float displayLatency;
+	uint64_t lastPingTimestamp;
+	uint64_t lastStatsTimestamp;
 };
 
 #endif // !NETWORK_MANAGER_H
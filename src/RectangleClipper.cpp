@@ -0,0 +1,141 @@
+#include "RectangleClipper.h"
+
+RectangleClipper::RectangleClipper()
+{
+	this->pipelineCount = 0;
+}
+
+void RectangleClipper::clear()
+{
+	this->pipelineCount = 0;
+}
+
+int RectangleClipper::addRectangle(const ofRectangle& rectangle, float scale)
+{
+	if (this->pipelineCount == this->pipelines.size()) {
+		this->pipelines.push_back(Pipeline());
+	}
+
+	Pipeline& pipeline = this->pipelines[this->pipelineCount];
+	pipeline.left = rectangle.getLeft();
+	pipeline.right = rectangle.getRight();
+	pipeline.top = rectangle.getTop();
+	pipeline.bottom = rectangle.getBottom();
+	pipeline.scale = scale;
+	pipeline.result.clear();
+
+	return this->pipelineCount++;
+}
+
+void RectangleClipper::clip(const ContourBuffer& contour)
+{
+	const int n = contour.size();
+	const float* xs = contour.getX();
+	const float* ys = contour.getY();
+
+	for (int p = 0; p < this->pipelineCount; p++) {
+		Pipeline& pipeline = this->pipelines[p];
+		pipeline.result.clear();
+		for (int s = 0; s < 4; s++) pipeline.stages[s].hasFirst = false;
+	}
+	if (n < 3) return;
+
+	// Rectangles which don't touch the contour's bounding box can't have any output
+	float minX = xs[0], maxX = xs[0], minY = ys[0], maxY = ys[0];
+	for (int i = 1; i < n; i++) {
+		minX = min(minX, xs[i]);
+		maxX = max(maxX, xs[i]);
+		minY = min(minY, ys[i]);
+		maxY = max(maxY, ys[i]);
+	}
+
+	for (int i = 0; i < n; i++) {
+		for (int p = 0; p < this->pipelineCount; p++) {
+			Pipeline& pipeline = this->pipelines[p];
+			if (pipeline.right < minX || pipeline.left > maxX || pipeline.bottom < minY || pipeline.top > maxY) continue;
+			this->push(pipeline, 0, xs[i], ys[i]);
+		}
+	}
+
+	for (int p = 0; p < this->pipelineCount; p++) {
+		this->close(this->pipelines[p], 0);
+	}
+}
+
+int RectangleClipper::size() const
+{
+	return this->pipelineCount;
+}
+
+const ContourBuffer& RectangleClipper::getResult(int index) const
+{
+	return this->pipelines[index].result;
+}
+
+void RectangleClipper::push(Pipeline& pipeline, int stage, float x, float y)
+{
+	if (stage == 4) {
+		pipeline.result.addPoint((x - pipeline.left) * pipeline.scale, (y - pipeline.top) * pipeline.scale);
+		return;
+	}
+
+	Stage& current = pipeline.stages[stage];
+	const bool inside = this->isInside(pipeline, stage, x, y);
+
+	if (!current.hasFirst) {
+		current.hasFirst = true;
+		current.firstX = x;
+		current.firstY = y;
+	}
+	else if (inside != current.previousInside) {
+		float ix, iy;
+		this->intersect(pipeline, stage, current.previousX, current.previousY, x, y, ix, iy);
+		this->push(pipeline, stage + 1, ix, iy);
+	}
+
+	if (inside) this->push(pipeline, stage + 1, x, y);
+
+	current.previousX = x;
+	current.previousY = y;
+	current.previousInside = inside;
+}
+
+// Closing edge of each stage, from its last vertex back to its first one
+void RectangleClipper::close(Pipeline& pipeline, int stage)
+{
+	if (stage == 4) return;
+
+	Stage& current = pipeline.stages[stage];
+	if (current.hasFirst) {
+		const bool firstInside = this->isInside(pipeline, stage, current.firstX, current.firstY);
+		if (firstInside != current.previousInside) {
+			float ix, iy;
+			this->intersect(pipeline, stage, current.previousX, current.previousY, current.firstX, current.firstY, ix, iy);
+			this->push(pipeline, stage + 1, ix, iy);
+		}
+	}
+
+	this->close(pipeline, stage + 1);
+}
+
+bool RectangleClipper::isInside(const Pipeline& pipeline, int stage, float x, float y) const
+{
+	switch (stage) {
+	case 0: return x >= pipeline.left;
+	case 1: return x <= pipeline.right;
+	case 2: return y >= pipeline.top;
+	default: return y <= pipeline.bottom;
+	}
+}
+
+void RectangleClipper::intersect(const Pipeline& pipeline, int stage, float x0, float y0, float x1, float y1, float& x, float& y) const
+{
+	if (stage < 2) {
+		x = (stage == 0) ? pipeline.left : pipeline.right;
+		y = y0 + (y1 - y0) * (x - x0) / (x1 - x0);
+	}
+	else {
+		y = (stage == 2) ? pipeline.top : pipeline.bottom;
+		x = x0 + (x1 - x0) * (y - y0) / (y1 - y0);
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ContourBuffer.h"
+
+#ifndef RECTANGLE_CLIPPER_H
+#define RECTANGLE_CLIPPER_H
+
+using namespace std;
+
+// Clips one closed contour against a batch of axis aligned rectangles (Sutherland-Hodgman).
+// Each rectangle has its own 4 stage pipeline (left, right, top, bottom edge), and the contour
+// vertices are streamed once through all the pipelines. Results come out already translated and
+// scaled into the rectangle's own space, i.e. (point - rectangle origin) * scale.
+class RectangleClipper {
+public:
+	RectangleClipper();
+
+	void clear();
+	int addRectangle(const ofRectangle& rectangle, float scale);
+	void clip(const ContourBuffer& contour);
+
+	int size() const;
+	const ContourBuffer& getResult(int index) const;
+
+private:
+	struct Stage {
+		bool hasFirst;
+		float firstX, firstY;
+		float previousX, previousY;
+		bool previousInside;
+	};
+
+	struct Pipeline {
+		float left, top, right, bottom;
+		float scale;
+		Stage stages[4];
+		ContourBuffer result;
+	};
+
+	// Pipelines are kept between frames so their result buffers don't get reallocated
+	vector<Pipeline> pipelines;
+	int pipelineCount;
+
+	void push(Pipeline& pipeline, int stage, float x, float y);
+	void close(Pipeline& pipeline, int stage);
+	bool isInside(const Pipeline& pipeline, int stage, float x, float y) const;
+	void intersect(const Pipeline& pipeline, int stage, float x0, float y0, float x1, float y1, float& x, float& y) const;
+};
+
+#endif
@@ -3,6 +3,9 @@
 Sequencer::Sequencer()
 {
 	this->x = this->y = this->elementsPerRow = this->padding = this->elementSize = this->highlightedStep = 0;
+	this->trackedBody = NULL;
+	this->cacheEpsilon = Constants::SEQUENCER_CACHE_EPSILON;
+	this->clippedBody = NULL;
 }
 
 Sequencer::Sequencer(int x, int y, int elementsPerRow, int elementSize, int padding, ofColor color, ofColor accentColor, ofColor highlightColor)
@@ -17,6 +20,8 @@ Sequencer::Sequencer(int x, int y, int elementsPerRow, int elementSize, int padd
 	this->highlightColor = highlightColor;
 	this->highlightedStep = 0;
 	this->trackedBody = NULL;
+	this->cacheEpsilon = Constants::SEQUENCER_CACHE_EPSILON;
+	this->clippedBody = NULL;
 }
 
 void Sequencer::addSequencerStepForJoint(JointType j)
@@ -65,6 +70,14 @@ void Sequencer::setCurrentHighlight(int highlightedStep)
 	this->highlightedStep = highlightedStep;
 }
 
+void Sequencer::setCacheEpsilon(float cacheEpsilon)
+{
+	this->cacheEpsilon = cacheEpsilon;
+	for (auto it = this->steps.begin(); it != this->steps.end(); ++it) {
+		it->second->setCacheEpsilon(cacheEpsilon);
+	}
+}
+
 void Sequencer::update()
 {
 	if (this->trackedBody == NULL) return;
@@ -73,13 +86,55 @@ void Sequencer::update()
 	if (this->trackedBody->getCurrentlyPlaying16Joints().size() > this->highlightedStep)
 		this->highlightedJoint = this->trackedBody->getCurrentlyPlaying16Joints()[this->highlightedStep];
 
+	const bool isContourUnchanged = this->isContourUnchanged();
+	if (!isContourUnchanged) {
+		this->clippedBody = this->trackedBody;
+		this->clippedContour = this->trackedBody->contour;
+	}
+
+	this->stepClipper.clear();
+	this->clippedSteps.clear();
+	this->clippedStepScales.clear();
 	for (auto it = this->stepOrder.begin(); it != this->stepOrder.end(); ++it) {
 		JointType j = static_cast<JointType>(*it);
 		if (this->steps.find(j) == this->steps.end()) continue;
 		SequencerStep* step = this->steps[j];
 		step->registerBody(this->trackedBody, this->color, this->accentColor);
-		step->update();
+		if (isContourUnchanged && step->reuseCache()) continue;
+
+		ofRectangle clipRectangle = step->getClipRectangle(this->trackedBody);
+		if (clipRectangle.getWidth() <= 0) {
+			step->clearThumbnail();
+			continue;
+		}
+		float scale = step->getSize() / clipRectangle.getWidth();
+		this->stepClipper.addRectangle(clipRectangle, scale);
+		this->clippedSteps.push_back(step);
+		this->clippedStepScales.push_back(scale);
+	}
+	if (this->clippedSteps.size() == 0) return;
+
+	// Steps only rebuild their paths when their clipped contour moved
+	this->stepClipper.clip(this->trackedBody->contour);
+	for (int i = 0; i < this->clippedSteps.size(); i++) {
+		this->clippedSteps[i]->update(this->stepClipper.getResult(i), this->clippedStepScales[i]);
+	}
+}
+
+bool Sequencer::isContourUnchanged()
+{
+	const ContourBuffer& contour = this->trackedBody->contour;
+	if (this->clippedBody != this->trackedBody) return false;
+	if (contour.size() != this->clippedContour.size()) return false;
+
+	const float* xs = contour.getX();
+	const float* ys = contour.getY();
+	const float* clippedXs = this->clippedContour.getX();
+	const float* clippedYs = this->clippedContour.getY();
+	for (int i = 0; i < contour.size(); i++) {
+		if (fabs(xs[i] - clippedXs[i]) > this->cacheEpsilon || fabs(ys[i] - clippedYs[i]) > this->cacheEpsilon) return false;
 	}
+	return true;
 }
 
 void Sequencer::draw()
@@ -2,6 +2,7 @@
 #include "ofMain.h"
 #include "ofxKinectForWindows2.h"
 #include "SequencerStep.h"
+#include "RectangleClipper.h"
 #include "TrackedBody.h"
 
 using namespace std;
@@ -15,6 +16,7 @@ public:
 	void setStepOrder(vector<JointType> order);
 	void setTrackedBody(TrackedBody* b);
 	void setCurrentHighlight(int highlightedStep);
+	void setCacheEpsilon(float cacheEpsilon);
 	void update();
 	void draw();
 private:
@@ -27,6 +29,18 @@ private:
 	map<JointType, SequencerStep*> steps;
 	TrackedBody* trackedBody;
 
+	// All steps are clipped out of the body contour in one pass
+	RectangleClipper stepClipper;
+	vector<SequencerStep*> clippedSteps;
+	vector<float> clippedStepScales;
+
+	// Body contour as of the last full clip. While the body stays within cacheEpsilon of it,
+	// steps whose joint didn't move keep their thumbnail without being clipped again
+	float cacheEpsilon;
+	TrackedBody* clippedBody;
+	ContourBuffer clippedContour;
+	bool isContourUnchanged();
+
 	ofVec2f getPositionForIndex(int index);
 	void addSequencerStep(SequencerStep* s);
 };
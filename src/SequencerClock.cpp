@@ -0,0 +1,145 @@
+#include "SequencerClock.h"
+
+SequencerClock::SequencerClock()
+{
+	this->lookahead = Constants::SEQUENCER_PATTERN_LOOKAHEAD_MS;
+	this->clear();
+}
+
+void SequencerClock::clear()
+{
+	this->count = 0;
+	this->next = 0;
+	this->step = -1;
+	this->lastStepTime = 0;
+	this->meanStep = 0;
+	this->meanTime = 0;
+	this->period = 0;
+	this->drift = 0;
+	this->jitter = 0;
+	this->resyncs = 0;
+}
+
+void SequencerClock::addStep(int value, uint64_t time)
+{
+	const int STEPS = Constants::SEQUENCER_STEPS;
+	value = ((value % STEPS) + STEPS) % STEPS;
+
+	if (this->step < 0) {
+		this->step = value;
+	}
+	else {
+		// The same step sent twice doesn't move the clock, a missed one just leaves a gap
+		int advance = (value - (int)(this->step % STEPS) + STEPS) % STEPS;
+		if (advance == 0) return;
+		this->step += advance;
+	}
+	this->lastStepTime = time;
+
+	if (this->count >= MIN_STEPS) {
+		float error = ((int64_t)time - (int64_t)this->getStepTime(this->step)) / 1000.0;
+		if (fabs(error) > this->period / 2000.0) {
+			this->count = 0;
+			this->next = 0;
+			this->resyncs++;
+		}
+		else {
+			this->drift += (error - this->drift) / 16;
+			this->jitter += (fabs(error - this->drift) - this->jitter) / 16;
+		}
+	}
+
+	this->steps[this->next] = this->step;
+	this->times[this->next] = time;
+	this->next = (this->next + 1) % WINDOW;
+	this->count = min(this->count + 1, (int)WINDOW);
+	this->fit();
+}
+
+void SequencerClock::fit()
+{
+	// Relative to the newest pair, to keep the sums small
+	const int newest = (this->next + WINDOW - 1) % WINDOW;
+	const int64_t baseStep = this->steps[newest];
+	const uint64_t baseTime = this->times[newest];
+
+	double sumStep = 0, sumTime = 0;
+	for (int i = 0; i < this->count; i++) {
+		sumStep += this->steps[i] - baseStep;
+		sumTime += (int64_t)(this->times[i] - baseTime);
+	}
+	double meanStep = sumStep / this->count;
+	double meanTime = sumTime / this->count;
+
+	double covariance = 0, variance = 0;
+	for (int i = 0; i < this->count; i++) {
+		double x = this->steps[i] - baseStep - meanStep;
+		double y = (int64_t)(this->times[i] - baseTime) - meanTime;
+		covariance += x * y;
+		variance += x * x;
+	}
+
+	this->meanStep = baseStep + meanStep;
+	this->meanTime = baseTime + meanTime;
+	if (variance > 0 && covariance > 0) this->period = covariance / variance;
+}
+
+bool SequencerClock::isRunning(uint64_t now)
+{
+	if (this->count < MIN_STEPS || this->period <= 0) return false;
+	return now < this->lastStepTime + (uint64_t)(4 * this->period);
+}
+
+double SequencerClock::getStepAt(uint64_t time)
+{
+	if (this->period <= 0) return this->step;
+	return this->meanStep + ((double)time - this->meanTime) / this->period;
+}
+
+uint64_t SequencerClock::getStepTime(int64_t step)
+{
+	return (uint64_t)max(0.0, this->meanTime + (step - this->meanStep) * this->period);
+}
+
+int64_t SequencerClock::getBarAt(uint64_t time)
+{
+	// Bars start on counter value 1
+	const int STEPS = Constants::SEQUENCER_STEPS;
+	int64_t step = (int64_t)floor(this->getStepAt(time));
+	return step - (((step - 1) % STEPS) + STEPS) % STEPS;
+}
+
+void SequencerClock::setLookahead(float lookaheadMs)
+{
+	this->lookahead = lookaheadMs;
+}
+
+float SequencerClock::getLookahead()
+{
+	return this->lookahead;
+}
+
+int64_t SequencerClock::getBarToDispatch(uint64_t now)
+{
+	return this->getBarAt(now + (uint64_t)(this->lookahead * 1000));
+}
+
+float SequencerClock::getStepPeriodMs()
+{
+	return this->period / 1000.0;
+}
+
+float SequencerClock::getDriftMs()
+{
+	return this->drift;
+}
+
+float SequencerClock::getJitterMs()
+{
+	return this->jitter;
+}
+
+int SequencerClock::getResyncs()
+{
+	return this->resyncs;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include "ofMain.h"
+#include "Constants.h"
+
+#ifndef SEQUENCER_CLOCK_H
+#define SEQUENCER_CLOCK_H
+
+using namespace std;
+
+// Local estimate of MaxMSP's sequencer clock, from the step counter it sends (1 to SEQUENCER_STEPS, every step).
+// Steps are counted up without wrapping; a least squares line through the last WINDOW (step, arrival time)
+// pairs gives the step period and phase, so the time of any step, like the start of the next bar, can be
+// predicted. Every arrival is also checked against the prediction made before it: the running mean of the
+// error is the drift (positive: steps come in later than predicted), its mean deviation the jitter.
+// An error over half a step (tempo change, transport restart) starts the estimate over.
+// Times are local ofGetElapsedTimeMicros().
+class SequencerClock {
+public:
+	SequencerClock();
+	void clear();
+
+	void addStep(int step, uint64_t time);
+
+	// Enough steps for an estimate, and the last one recent enough for the sequencer to still be running
+	bool isRunning(uint64_t now);
+	// Step counted since the first one received, fractional; step % SEQUENCER_STEPS is the counter value
+	double getStepAt(uint64_t time);
+	uint64_t getStepTime(int64_t step);
+	// First step of the bar playing at time
+	int64_t getBarAt(uint64_t time);
+
+	// How long before a bar starts its pattern should be sent
+	void setLookahead(float lookaheadMs);
+	float getLookahead();
+	// Bar whose pattern is due at now: the one playing lookahead from now
+	int64_t getBarToDispatch(uint64_t now);
+
+	float getStepPeriodMs();
+	float getDriftMs();
+	float getJitterMs();
+	int getResyncs();
+
+	static const int WINDOW = 32;
+	static const int MIN_STEPS = 4;
+
+private:
+	int64_t steps[WINDOW];
+	uint64_t times[WINDOW];
+	int count;
+	int next;
+
+	int64_t step;
+	uint64_t lastStepTime;
+
+	// Fitted line: time = meanTime + period * (step - meanStep)
+	double meanStep;
+	double meanTime;
+	double period;
+
+	float lookahead;
+	float drift;
+	float jitter;
+	int resyncs;
+
+	void fit();
+};
+
+#endif
@@ -1,5 +1,8 @@
 #include "SequencerStep.h"
 
+uint64_t SequencerStep::cacheHits = 0;
+uint64_t SequencerStep::cacheMisses = 0;
+
 SequencerStep::SequencerStep()
 {
 	this->x = this->y = this->size = this->clipSize = 0;
@@ -7,6 +10,8 @@ SequencerStep::SequencerStep()
 	this->highlightColor = ofColor(0, 0, 0, 0);
 	this->bodies.clear();
 	this->initializeClipSizes();
+	this->cacheValid = false;
+	this->cacheEpsilon = Constants::SEQUENCER_CACHE_EPSILON;
 }
 
 SequencerStep::SequencerStep(float x, float y, float size, JointType joint, ofColor strokeColor, ofColor highlightColor)
@@ -24,56 +29,119 @@ SequencerStep::SequencerStep(float x, float y, float size, JointType joint, ofCo
 		this->clipSize = this->clipSizes[joint];
 	else
 		this->clipSize = 400;
+	this->cacheValid = false;
+	this->cacheEpsilon = Constants::SEQUENCER_CACHE_EPSILON;
 }
 
 void SequencerStep::registerBody(TrackedBody* body, ofColor strokeColor, ofColor fillColor)
 {
+	// Same body as last time, keep the cached thumbnail
+	if (this->bodies.size() == 1 && this->bodies[0].body == body &&
+		this->bodies[0].strokeColor == strokeColor && this->bodies[0].fillColor == fillColor) return;
+
+	this->cacheValid = false;
 	this->paths.clear();
 	this->bodies.clear();
 	BodyCapture b = BodyCapture(body, this->joint, strokeColor, fillColor);
 	this->bodies.push_back(b);
 }
 
-void SequencerStep::update()
+// Square around the step's joint, in the body's coordinates
+ofRectangle SequencerStep::getClipRectangle(TrackedBody* body)
 {
-	for (auto& bc : this->bodies) {
-		TrackedBody* body = bc.body;
-		ofVec2f clipPosition = body->getJointPosition(bc.joint);
-		if (body->contour.size() < 3) continue;
-
-		try {
-			body->contour.close();
-			this->clipper.Clear();
-			this->clipper.addPolyline(body->contour, ClipperLib::ptSubject);
-		}
-		catch (const std::exception& e) {
-			this->currentPath.clear();
-			this->paths.push_back(this->currentPath);
-			return;
-		}
-		
-		float normalizedClipSize = this->clipSize * body->getScreenRatio();
-
-		ofRectangle rect = ofRectangle(clipPosition.x - normalizedClipSize / 2, clipPosition.y - normalizedClipSize / 2, normalizedClipSize, normalizedClipSize);
-		this->clipper.addRectangle(rect, ClipperLib::ptClip);
-
-		auto intersection = clipper.getClipped(ClipperLib::ClipType::ctIntersection);
-		glm::vec2 lineOffset = clipPosition - ofVec2f(normalizedClipSize / 2, normalizedClipSize / 2);
-		
-		this->currentPath.clear();
-		for (auto& line : intersection) {
-			this->currentPath.moveTo(line[0]);
-			for (int i = 1; i < line.size(); i++) {
-				this->currentPath.lineTo(line[i]);
-			}
-			this->currentPath.close();
+	ofVec2f clipPosition = body->getJointPosition(this->joint);
+	float normalizedClipSize = this->clipSize * body->getScreenRatio();
+	return ofRectangle(clipPosition.x - normalizedClipSize / 2, clipPosition.y - normalizedClipSize / 2, normalizedClipSize, normalizedClipSize);
+}
+
+float SequencerStep::getSize()
+{
+	return this->size;
+}
+
+void SequencerStep::setCacheEpsilon(float cacheEpsilon)
+{
+	if (cacheEpsilon == this->cacheEpsilon) return;
+	this->cacheEpsilon = cacheEpsilon;
+	this->cacheValid = false;
+}
+
+uint64_t SequencerStep::getCacheHits()
+{
+	return SequencerStep::cacheHits;
+}
+
+uint64_t SequencerStep::getCacheMisses()
+{
+	return SequencerStep::cacheMisses;
+}
+
+// The clipped contour comes from the sequencer's batched clipper, already in thumbnail space (scaled by scale)
+void SequencerStep::update(const ContourBuffer& clippedContour, float scale)
+{
+	if (this->bodies.size() == 0) return;
+
+	ofVec2f jointPosition = this->bodies[0].body->getJointPosition(this->joint);
+	if (this->isCacheHit(clippedContour, jointPosition, scale)) {
+		SequencerStep::cacheHits++;
+		return;
+	}
+	SequencerStep::cacheMisses++;
+
+	this->cacheValid = true;
+	this->cachedJointPosition = jointPosition;
+	this->cachedContour.resize(clippedContour.size());
+	memcpy(this->cachedContour.getX(), clippedContour.getX(), clippedContour.size() * sizeof(float));
+	memcpy(this->cachedContour.getY(), clippedContour.getY(), clippedContour.size() * sizeof(float));
+
+	this->paths.resize(1);
+	ofPath& path = this->paths[0];
+	path.clear();
+	if (clippedContour.size() >= 3) {
+		const float* xs = clippedContour.getX();
+		const float* ys = clippedContour.getY();
+		path.moveTo(xs[0], ys[0]);
+		for (int i = 1; i < clippedContour.size(); i++) {
+			path.lineTo(xs[i], ys[i]);
 		}
-		this->currentPath.translate(-lineOffset);
-		float scale = (1.0 * this->size) / (1.0 * normalizedClipSize);
-		this->currentPath.scale(scale, scale);
+		path.close();
+	}
+}
 
-		this->paths.push_back(this->currentPath);
+bool SequencerStep::reuseCache()
+{
+	if (!this->cacheValid || this->bodies.size() == 0) return false;
+	ofVec2f jointPosition = this->bodies[0].body->getJointPosition(this->joint);
+	if (jointPosition.distance(this->cachedJointPosition) > this->cacheEpsilon) return false;
+	SequencerStep::cacheHits++;
+	return true;
+}
+
+// Nothing to show (degenerate clip rectangle), drop the old thumbnail instead of drawing it stale
+void SequencerStep::clearThumbnail()
+{
+	this->cacheValid = false;
+	this->paths.clear();
+}
+
+bool SequencerStep::isCacheHit(const ContourBuffer& clippedContour, const ofVec2f& jointPosition, float scale)
+{
+	if (!this->cacheValid) return false;
+	if (jointPosition.distance(this->cachedJointPosition) > this->cacheEpsilon) return false;
+
+	const int n = clippedContour.size();
+	if (n != this->cachedContour.size()) return false;
+
+	// Contours are in thumbnail space, so the epsilon scales with them
+	const float epsilon = this->cacheEpsilon * scale;
+	const float* xs = clippedContour.getX();
+	const float* ys = clippedContour.getY();
+	const float* cachedXs = this->cachedContour.getX();
+	const float* cachedYs = this->cachedContour.getY();
+	for (int i = 0; i < n; i++) {
+		if (fabs(xs[i] - cachedXs[i]) > epsilon || fabs(ys[i] - cachedYs[i]) > epsilon) return false;
 	}
+	return true;
 }
 
 void SequencerStep::draw(float x, float y, bool isHighlighted) {
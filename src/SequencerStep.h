@@ -1,7 +1,7 @@
 #pragma once
 #include "ofMain.h"
 #include "ofxKinectForWindows2.h"
-#include "ofxClipper.h"
+#include "ContourBuffer.h"
 #include "TrackedBody.h"
 
 using namespace std;
@@ -31,19 +31,37 @@ public:
 	SequencerStep();
 	SequencerStep(float x, float y, float size, JointType joint, ofColor strokeColor, ofColor highlightColor);
 	void registerBody(TrackedBody* body, ofColor strokeColor, ofColor fillColor);
-	void update();
+	ofRectangle getClipRectangle(TrackedBody* body);
+	float getSize();
+	void update(const ContourBuffer& clippedContour, float scale);
+	// Before clipping: true (and counted as a hit) if the cached thumbnail still holds for the body's joint,
+	// as long as the body contour itself hasn't moved
+	bool reuseCache();
+	void clearThumbnail();
+	void setCacheEpsilon(float cacheEpsilon);
 	void draw(bool isHighlighted = false);
 	void draw(float x, float y, bool isHighlighted = false);
 	JointType joint;
+
+	static uint64_t getCacheHits();
+	static uint64_t getCacheMisses();
 private:
 	float x, y, size;
 	float clipSize;	
 	ofColor strokeColor;
 	ofColor highlightColor;
 	vector<BodyCapture> bodies;
-	ofPath currentPath;
 	vector<ofPath> paths;
-	ofx::Clipper clipper;
 	map<JointType, float> clipSizes;
 	void initializeClipSizes();
+
+	// Thumbnail cache, only rebuilt when the joint or the clipped contour moved more than cacheEpsilon
+	bool cacheValid;
+	float cacheEpsilon;
+	ofVec2f cachedJointPosition;
+	ContourBuffer cachedContour;
+	bool isCacheHit(const ContourBuffer& clippedContour, const ofVec2f& jointPosition, float scale);
+
+	static uint64_t cacheHits;
+	static uint64_t cacheMisses;
 };
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include "ofMain.h"
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+using namespace std;
+
+// Fixed capacity queue between exactly one producer thread and one consumer thread, without locks.
+// Slots are built once and reused: the producer fills the slot prepare() hands out (swap data in to
+// avoid copies) and makes it visible with push(), the consumer reads front() and hands it back with pop().
+template <typename T>
+class SpscRing {
+public:
+	SpscRing(int capacity) : slots(capacity + 1), head(0), tail(0) {}
+
+	// Producer: slot to fill, NULL when the ring is full
+	T* prepare() {
+		size_t tail = this->tail.load(memory_order_relaxed);
+		if (this->next(tail) == this->head.load(memory_order_acquire)) return NULL;
+		return &this->slots[tail];
+	}
+
+	void push() {
+		size_t tail = this->tail.load(memory_order_relaxed);
+		this->tail.store(this->next(tail), memory_order_release);
+	}
+
+	// Consumer: oldest slot, NULL when the ring is empty
+	T* front() {
+		size_t head = this->head.load(memory_order_relaxed);
+		if (head == this->tail.load(memory_order_acquire)) return NULL;
+		return &this->slots[head];
+	}
+
+	void pop() {
+		size_t head = this->head.load(memory_order_relaxed);
+		this->head.store(this->next(head), memory_order_release);
+	}
+
+	int getCapacity() { return this->slots.size() - 1; }
+
+private:
+	vector<T> slots;
+	atomic<size_t> head;
+	atomic<size_t> tail;
+
+	size_t next(size_t index) { return (index + 1 == this->slots.size()) ? 0 : index + 1; }
+};
+
+#endif
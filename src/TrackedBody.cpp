@@ -12,18 +12,29 @@ TrackedBody::TrackedBody(int index, float smoothingFactor, int contourPoints, in
 	this->index = index;
 	this->smoothingFactor = smoothingFactor;
 	this->contourPoints = contourPoints;
+	this->contourIndexOffset = 0;
+	this->alignedSequence = 0;
 	this->instrumentId = -1;	
-	this->speedShader.load("shaders_gl3/bodySpeed");
-	this->hlinesShader.load("shaders_gl3/hlines");
-	this->vlinesShader.load("shaders_gl3/vlines");
-	this->gridShader.load("shaders_gl3/grid");
-	this->fillShader.load("shaders_gl3/fill");
-	this->dotsShader.load("shaders_gl3/dots");
-
-	this->mainFbo.allocate(DEPTH_WIDTH, DEPTH_HEIGHT);
-	this->polyFbo.allocate(DEPTH_WIDTH, DEPTH_HEIGHT);
+	this->siteId = 0;
+	GpuResourcePool* gpuResources = GpuResourcePool::getInstance();
+	this->hlinesShader = gpuResources->getShader("hlines");
+	this->vlinesShader = gpuResources->getShader("vlines");
+	this->gridShader = gpuResources->getShader("grid");
+	this->dotsShader = gpuResources->getShader("dots");
+	this->polyFbo = NULL;
 
 	this->noContours = noDelayedContours;
+	for (int ct = 0; ct < this->noContours; ct++) {
+		this->delayedContourSmoothings.push_back(ofMap(sqrt(ct), 0, sqrt(this->noContours), 0.9, 0.999));
+	}
+	this->contourPolylineDirty = true;
+
+	// Contour buffers are allocated once, for the largest number of points we can be asked for
+	this->rawContour.reserve(Constants::MAX_CONTOUR_POINTS);
+	this->contour.reserve(Constants::MAX_CONTOUR_POINTS);
+	this->transmittedContour.reserve(Constants::MAX_CONTOUR_POINTS);
+	this->transmissionError = 0;
+	this->dataFrame = 0;
 	this->isRemote = isRemote;
 	this->isTracked = false;
 
@@ -40,11 +51,50 @@ TrackedBody::TrackedBody(int index, float smoothingFactor, int contourPoints, in
 
 	this->isRecording = false;
 	this->generalColor = ofColor(255, 225, 128, 255);
-	this->segment = new ofPath();
+}
+
+TrackedBody::~TrackedBody()
+{
+	this->reset(this->index);
+	delete this->bodySoundPlayer;
+}
+
+// Bodies are pooled: this puts a body back in the state of a freshly constructed one, keeping its buffers
+void TrackedBody::reset(int index)
+{
+	if (this->instrumentId != -1) this->removeInstrument();
+	this->releaseGpuResources();
+
+	this->index = index;
+	this->isTracked = false;
+	this->isRecording = false;
+	this->contourIndexOffset = 0;
+	this->alignedSequence = 0;
+	this->generalColor = ofColor(255, 225, 128, 255);
+
+	this->rawContour.clear();
+	this->contour.clear();
+	this->transmittedContour.clear();
+	for (auto& delayedContour : this->delayedContours) delayedContour.clear();
+	this->contourPolylineDirty = true;
+	this->dataFrame = 0;
+	this->voronoiPoints.clear();
+
+	this->joints.clear();
+	this->jointStorage.clear();
+	this->latestSkeleton.clear();
+
+	this->bodySoundPlayer->reset(index);
 }
 
 // ------ Setting state ------
 
+void TrackedBody::releaseGpuResources()
+{
+	GpuResourcePool::getInstance()->releaseFbo(this->polyFbo);
+	this->polyFbo = NULL;
+}
+
 void TrackedBody::setOSCManager(MaxMSPNetworkManager* m)
 {
 	this->maxMSPNetworkManager = m;
@@ -67,6 +117,12 @@ void TrackedBody::setIsTracked(bool isTracked)
 	}
 
 	this->isTracked = isTracked;
+	if (!isTracked) this->releaseGpuResources();
+}
+
+void TrackedBody::setContourTransmissionError(float transmissionError)
+{
+	this->transmissionError = transmissionError;
 }
 
 void TrackedBody::setNumberOfContourPoints(int contourPoints)
@@ -74,6 +130,8 @@ void TrackedBody::setNumberOfContourPoints(int contourPoints)
 	if (contourPoints != this->contourPoints) {
 		this->contourPoints = contourPoints;
 		this->contour.clear();
+		this->contourPolylineDirty = true;
+		this->dataFrame = ofGetFrameNum();
 		this->delayedContours.clear();
 		this->voronoiPoints.clear();
 	}
@@ -112,88 +170,87 @@ void TrackedBody::updateSkeletonData(map<JointType, ofxKinectForWindows2::Data::
 void TrackedBody::updateJointPosition(JointType joint, ofVec2f position)
 {	
 	if (this->joints.find(joint) == joints.end()) {
-		this->joints[joint] = new TrackedJoint(joint);
+		this->jointStorage[joint] = TrackedJoint(joint);
+		this->joints[joint] = &this->jointStorage[joint];
 	}
 
 	TrackedJoint* currentJoint = this->joints[joint];
 	currentJoint->setPosition(position, this->smoothingFactor);
 }
 
-void TrackedBody::updateContourData(vector<ofPolyline> contours)
+void TrackedBody::updateContourData(const ContourBuffer& newRawContour)
 {
-	if (contours.size() == 0) return;
-	// 1. Discard all contours except for the one of maximum perimeter
-	// If this is not precise enough, can use the area (but that's probably more
-	// computationally expensive)
-	pair<int, float> maxContour = make_pair(-1, -1.0f);
-	for (int i = 0; i < contours.size(); i++) {
-		float perimeter = contours[i].getPerimeter();
-		if (perimeter > maxContour.second) {
-			maxContour = make_pair(i, perimeter);
-		}
-	}
+	if (newRawContour.size() == 0) return;
+	// 1. Resample the body's largest contour (picked by the contour tracer) to the desired number of points.
+	this->contourResampler.setSource(newRawContour);
+	this->contourResampler.resample(this->contourPoints, this->rawContour);
 
-	// 2. Save largest area contour and resample it to the desired number of points.
-	ofPolyline newContour = contours[maxContour.first].getResampledByCount(this->contourPoints);
-	this->rawContour = ofPolyline(newContour);
+	// The peer gets as many points as the silhouette's detail needs, and resamples them on its side
+	if (!this->isRemote && this->transmissionError > 0) {
+		this->contourSimplifier.simplify(newRawContour, this->transmissionError, Constants::MAX_CONTOUR_POINTS, this->transmittedContour);
+	}
 
-	// 3. Match with persistent contour
+	// 2. Match with persistent contour
 	if (this->contour.size() == 0) {
-		this->contour = newContour;
-		for (int i = 0; i < this->noContours; i++) {
-			this->delayedContours.push_back(ofPolyline(newContour));
-		}
+		this->contour = this->rawContour;
+		this->delayedContours.assign(this->noContours, this->rawContour);
 	} 
 	else {
-		// Select matchesToCheck closest points in the new line to the first point in the persistent line
-		// And then checked the total distance between the circular permutations, in order to find the right order.
-		const int matchesToCheck = 5;
+		// Find the circular permutation of the new line with the smallest total distance to the persistent line.
+		// All offsets are checked at once through an FFT cross-correlation.
+		this->contourIndexOffset = this->contourAligner.findBestOffset(this->contour, this->rawContour);
 
-		auto newVertices = newContour.getVertices();
-		auto persistentVertices = this->contour.getVertices();
-		ofVec2f referencePersistentVertex = ofVec2f(persistentVertices[0]);		
-		vector<float> distances;
-
-		for (auto it = newVertices.begin(); it != newVertices.end(); ++it) {
-			distances.push_back(referencePersistentVertex.squareDistance(ofVec2f(*it)));
-		}
-		
-		nth_element(distances.begin(), distances.begin() + matchesToCheck, distances.end());
-		float thresholdDistance = distances[matchesToCheck - 1];
-
-		pair<int, float> minDistance = make_pair(-1, 1000000000.0f);
-		for (int i = 0; i < newVertices.size(); i++) {
-			float sqDistance = referencePersistentVertex.squareDistance(ofVec2f(newVertices[i]));
-			if (sqDistance <= thresholdDistance + 0.1f) {
-				// We have a candidate
-				float distance = GeometryUtils::getPolylineSquaredDistanceWithOffset(this->contour, newContour, i);
-				if (distance < minDistance.second) minDistance = make_pair(i, distance);			
-			}
-		}
+		// 3. Update persistent contour, with smoothing
+		this->contour.smoothTowards(this->rawContour, this->contourIndexOffset, this->smoothingFactor);
+	}
+	this->contourPolylineDirty = true;
+	this->dataFrame = ofGetFrameNum();
+}
 
-		this->contourIndexOffset = minDistance.first;
+// Jitter buffer frames move a little on every frame and are smooth already: taken as they are, and only
+// matched against the persistent contour when the buffer moves on to another received frame
+void TrackedBody::updateInterpolatedContour(const ContourBuffer& newRawContour, uint32_t sequence)
+{
+	if (newRawContour.size() == 0) return;
+	this->contourResampler.setSource(newRawContour);
+	this->contourResampler.resample(this->contourPoints, this->rawContour);
 
-		// 4. Update persistent contour, with smoothing
-		for (int i = 0; i < this->contour.size(); i++) {
-			int newIndex = (i + this->contourIndexOffset) % newContour.size();
-			this->contour[i].x = (1 - this->smoothingFactor) * newContour[newIndex].x + this->smoothingFactor * this->contour[i].x;
-			this->contour[i].y = (1 - this->smoothingFactor) * newContour[newIndex].y + this->smoothingFactor * this->contour[i].y;
+	if (this->contour.size() == 0) {
+		this->contour = this->rawContour;
+		this->delayedContours.assign(this->noContours, this->rawContour);
+	}
+	else {
+		if (sequence != this->alignedSequence) {
+			this->contourIndexOffset = this->contourAligner.findBestOffset(this->contour, this->rawContour);
 		}
-	}	
+		this->contour.smoothTowards(this->rawContour, this->contourIndexOffset, 0);
+	}
+	this->alignedSequence = sequence;
+	this->contourPolylineDirty = true;
+	this->dataFrame = ofGetFrameNum();
+}
+
+uint64_t TrackedBody::getDataFrame()
+{
+	return this->dataFrame;
 }
 
 void TrackedBody::updateDelayedContours() {
 	if (this->contour.size() == 0) return;
 	for (int ct = 0; ct < this->delayedContours.size(); ct++) {
-		float smoothing = ofMap(sqrt(ct), 0, sqrt(this->delayedContours.size()), 0.9, 0.999);
-		for (int i = 0; i < delayedContours[ct].size(); i++) {
-			int newIndex = (i + this->contourIndexOffset) % this->contour.size();
-			delayedContours[ct][i].x = (1 - smoothing) * this->contour[newIndex].x + smoothing * delayedContours[ct][i].x;
-			delayedContours[ct][i].y = (1 - smoothing) * this->contour[newIndex].y + smoothing * delayedContours[ct][i].y;
-		}
+		this->delayedContours[ct].smoothTowards(this->contour, this->contourIndexOffset, this->delayedContourSmoothings[ct]);
 	}
 }
 
+const ofPolyline& TrackedBody::getContourPolyline()
+{
+	if (this->contourPolylineDirty) {
+		this->contour.toPolyline(this->contourPolyline);
+		this->contourPolylineDirty = false;
+	}
+	return this->contourPolyline;
+}
+
 
 // ------ Calculating metrics on the body, to send to MaxMSP ------
 
@@ -243,31 +300,34 @@ float TrackedBody::getScreenRatio()
 
 pair<ofPath*, ofRectangle> TrackedBody::getContourSegment(int start, int amount)
 {
-	//ofPolyline ctr = this->contour;
-	ofPolyline* ctr = &(this->delayedContours[this->delayedContours.size() - 1]);
-	this->segment->clear();
-	int index = start % ctr->size();
+	this->segment.clear();
+	ofRectangle rect;
+	if (this->delayedContours.size() == 0 || this->delayedContours.back().size() == 0) return make_pair(&this->segment, rect);
+
+	const ContourBuffer& ctr = this->delayedContours.back();
+	const float* x = ctr.getX();
+	const float* y = ctr.getY();
+	int index = start % ctr.size();
 	int total = 0;
-	this->segment->moveTo((*ctr)[index]);
+	this->segment.moveTo(x[index], y[index]);
 
-	ofRectangle rect;
-	rect.x = rect.width = (*ctr)[index].x;
-	rect.y = rect.height = (*ctr)[index].y;
+	rect.x = rect.width = x[index];
+	rect.y = rect.height = y[index];
 
 	while (total < amount) {
-		index = (index + 1) % (*ctr).size();
+		index = (index + 1) % ctr.size();
 		total++;
-		this->segment->lineTo((*ctr)[index]);
+		this->segment.lineTo(x[index], y[index]);
 
-		rect.x = fmin(rect.x, (*ctr)[index].x);
-		rect.y = fmin(rect.y, (*ctr)[index].y);
-		rect.width = fmax(rect.width, (*ctr)[index].x);
-		rect.height = fmax(rect.height, (*ctr)[index].y);
+		rect.x = fmin(rect.x, x[index]);
+		rect.y = fmin(rect.y, y[index]);
+		rect.width = fmax(rect.width, x[index]);
+		rect.height = fmax(rect.height, y[index]);
 	}
 
 	rect.width -= rect.x;
 	rect.height -= rect.y;
-	return make_pair(this->segment, rect);
+	return make_pair(&this->segment, rect);
 }
 
 // ------ Update per frame ------
@@ -351,7 +411,7 @@ void TrackedBody::drawContours()
 	if (this->contour.size() < 3) return;
 	ofPushStyle();
 	ofSetColor(this->generalColor);
-	this->contour.draw();
+	this->getContourPolyline().draw();
 	ofPopStyle();
 }
 
@@ -363,10 +423,12 @@ void TrackedBody::setJointUniform(JointType joint, string uniformName, ofShader
 }
 
 void TrackedBody::drawContourForRaster(ofColor color) {
+	const float* x = this->contour.getX();
+	const float* y = this->contour.getY();
 	this->contourPath.clear();
-	this->contourPath.moveTo(this->contour[0]);
+	this->contourPath.moveTo(x[0], y[0]);
 	for (int i = 1; i < this->contour.size(); i++)
-		this->contourPath.lineTo(this->contour[i]);
+		this->contourPath.lineTo(x[i], y[i]);
 	this->contourPath.close();
 
 	this->contourPath.setFilled(true);
@@ -381,33 +443,35 @@ void TrackedBody::drawRaster()
 
 void TrackedBody::drawHLines()
 {
-	this->drawWithShader(&this->hlinesShader);
+	this->drawWithShader(this->hlinesShader);
 }
 
 void TrackedBody::drawVLines()
 {
-	this->drawWithShader(&this->vlinesShader);
+	this->drawWithShader(this->vlinesShader);
 }
 
 void TrackedBody::drawGrid()
 {
-	this->drawWithShader(&this->gridShader);
+	this->drawWithShader(this->gridShader);
 }
 
 void TrackedBody::drawDots()
 {
-	this->drawWithShader(&this->dotsShader);
+	this->drawWithShader(this->dotsShader);
 }
 
 void TrackedBody::drawWithShader(ofShader* shader) {
 	if (!this->isTracked) return;
 	if (this->contour.size() < 3) return;
 
+	if (this->polyFbo == NULL) this->polyFbo = GpuResourcePool::getInstance()->acquireFbo(DEPTH_WIDTH, DEPTH_HEIGHT);
+
 	// MainFboManager::end();
-	this->polyFbo.begin();
+	this->polyFbo->begin();
 	ofClear(0, 0, 0, 255);
 	this->drawContourForRaster(ofColor(255, 128, 128));
-	this->polyFbo.end();
+	this->polyFbo->end();
 	// MainFboManager::begin();
 
 	float time = ofGetSystemTimeMillis();
@@ -416,7 +480,7 @@ void TrackedBody::drawWithShader(ofShader* shader) {
 	shader->begin();
 	shader->setUniform1f("uTime", time);
 	shader->setUniform4f("color", color);
-	this->polyFbo.draw(0, 0);
+	this->polyFbo->draw(0, 0);
 	shader->end();
 }
 
@@ -475,6 +539,17 @@ int TrackedBody::getInstrumentId()
 	return this->instrumentId;
 }
 
+void TrackedBody::setSiteId(int siteId)
+{
+	this->siteId = siteId;
+}
+
+int TrackedBody::getSoundId()
+{
+	if (this->instrumentId < 0) return -1;
+	return this->siteId * Constants::MAX_INSTRUMENTS + this->instrumentId;
+}
+
 void TrackedBody::removeInstrument() {
 	TrackedBody::releaseInstrument(this->instrumentId);
 	this->instrumentId = -1;
@@ -503,147 +578,103 @@ void TrackedBody::releaseInstrument(int instrumentId)
 
 // ------ Serialization and deserialization, for sending data over the network (to MaxMSP & to other peer)
 
-string TrackedBody::serialize()
-{
-	/*
-	Message format is as following:
-	----
-	2 // Body index
-	__SKELETON__ // Constants::SKELETON_DELIMITER
-	3 // number of joints in message
-	1 245 218 // JointType, xPos, yPos
-	2 188 197
-	8 12 297
-	__CONTOUR__ // Constants::CONTOUR_DELIMITER
-	100 // number of points on the contour
-	12 23 // xPos, yPos for first point
-	68 72
-	...
-	108, 112
-	__IS_RECORDING__ // Constants::IS_RECORDING_DELIMITER
-	0 // or 1
-	__INSTRUMENT_ID__ // Constants::INSTRUMENT_ID_DELIMITER
-	2
-	----
-	*/
-	stringstream ss;
-	ss << this->index << "\n";
-	ss << Constants::SKELETON_DELIMITER << "\n";
-
-	int noJoints = this->joints.size();
-	ss << noJoints << "\n";
+void TrackedBody::serialize(BodyFrame& frame)
+{
+	// Encoded to the wire format by BodyDataCodec
+	frame.clear();
+	frame.index = this->index;
+	frame.captureTime = (uint32_t)ofGetSystemTimeMillis();
+	frame.isRecording = this->isRecording;
+	frame.instrumentId = this->getInstrumentId();
 
 	for (auto it = this->joints.begin(); it != this->joints.end(); ++it) {
-		JointType currentJoint = it->first;
-		TrackedJoint* j = it->second;
-		ss << currentJoint << " " << j->getTargetPosition().x << " " << j->getTargetPosition().y << "\n";
-	}
-
-	ss << Constants::CONTOUR_DELIMITER << "\n";
-	// Resample contour we're sending in order to save bandwidth
-	ofPolyline ctr = this->rawContour.getResampledByCount(this->contourPoints);
-	ss << ctr.size() << "\n";
-	for (int i = 0; i < ctr.size(); i++) {
-		ss << ctr[i].x << " " << ctr[i].y << "\n";
+		frame.setJoint(it->first, it->second->getTargetPosition());
 	}
 
-	ss << Constants::IS_RECORDING_DELIMITER << "\n";
-	ss << (int)this->isRecording << "\n";
-
-	ss << Constants::INSTRUMENT_ID_DELIMITER << "\n";
-	ss << this->getInstrumentId();
-
-	return ss.str();
+	// Either the simplified contour, or the raw contour already resampled to contourPoints in updateContourData.
+	// The receiver resamples whatever it gets to its own number of points.
+	bool isSimplified = this->transmissionError > 0 && this->transmittedContour.size() >= 3;
+	const ContourBuffer& sentContour = isSimplified ? this->transmittedContour : this->rawContour;
+	frame.contour.resize(sentContour.size());
+	memcpy(frame.contour.getX(), sentContour.getX(), sentContour.size() * sizeof(float));
+	memcpy(frame.contour.getY(), sentContour.getY(), sentContour.size() * sizeof(float));
 }
 
-void TrackedBody::deserialize(string s)
+void TrackedBody::deserialize(const BodyFrame& frame)
 {
-	istringstream ss(s);
-	int bodyIndex;
-	ss >> bodyIndex;
-	this->index = bodyIndex;
+	this->index = frame.index;
 
-	string delimiter;
-	ss >> delimiter;
+	// Interpolated frames from the jitter buffer aren't smoothed a second time
+	float smoothingFactor = this->smoothingFactor;
+	if (frame.isInterpolated) this->smoothingFactor = 0;
 
-	int noSkeletonPoints, joint;
-	float x, y;
-	ss >> noSkeletonPoints;
-	
-	for (int i = 0; i < noSkeletonPoints; i++) {
-		ss >> joint >> x >> y;
-		this->updateJointPosition(static_cast<JointType>(joint), ofVec2f(x, y));
+	for (int joint = 0; joint < JointType_Count; joint++) {
+		if (!frame.hasJoint(joint)) continue;
+		this->updateJointPosition(static_cast<JointType>(joint), frame.joints[joint]);
 	}
-	
-	ss >> delimiter;
-
-	int noContourPoints;
-	ss >> noContourPoints;
 
-	ofPolyline c;
-
-	for (int i = 0; i < noContourPoints; i++) {
-		ss >> x >> y;
-		c.addVertex(x, y);
+	if (frame.isInterpolated) {
+		this->updateInterpolatedContour(frame.contour, frame.sequence);
 	}
+	else {
+		// Only new messages get here (every few frames), smooth as much as rematching on every frame in between would have
+		int elapsedFrames = ofClamp((int)(ofGetFrameNum() - this->dataFrame), 1, 10);
+		this->smoothingFactor = pow(smoothingFactor, elapsedFrames);
+		this->updateContourData(frame.contour);
+	}
+	this->smoothingFactor = smoothingFactor;
 
-	this->updateContourData({ c });
-
-	ss >> delimiter;
-	bool isRecording;
-	ss >> isRecording;
-	this->setIsRecording(isRecording);
-
-	ss >> delimiter;
-	int instrumentId;
-	ss >> instrumentId;
-	this->assignInstrument(instrumentId);
+	this->setIsRecording(frame.isRecording);
+	this->assignInstrument(frame.instrumentId);
 }
 
 void TrackedBody::sendDataToMaxMSP()
 {	
 	float value;
 	float normalizedValue;	
+	const int soundId = this->getSoundId();
+	// Nothing to play before an instrument is assigned (remote bodies until their first frame)
+	if (soundId < 0) return;
 	// Sequencer sound data
-	this->bodySoundPlayer->sendOSC(this->instrumentId);
+	this->bodySoundPlayer->sendOSC(soundId);
 
 	if (ofGetFrameNum() % 3 != 0) return;
 	// Send whether is recording
-	this->maxMSPNetworkManager->sendIsRecording(this->instrumentId, this->getIsRecording());
+	this->maxMSPNetworkManager->sendIsRecording(soundId, this->getIsRecording());
 
 	// Distances
 	value = this->getNormalizedJointsDistance(JointType_WristLeft, JointType_KneeLeft);
 	normalizedValue = ofMap(value, 0, 1, 0, 1023);
-	this->maxMSPNetworkManager->sendBodyMessage(this->instrumentId, OscCategories::DISTANCE, "l-hand-l-knee", normalizedValue);
+	this->maxMSPNetworkManager->sendBodyMessage(soundId, MaxMSPNetworkManager::DISTANCE_L_HAND_L_KNEE, normalizedValue);
 
 	value = this->getNormalizedJointsDistance(JointType_KneeRight, JointType_WristRight);
 	normalizedValue = ofMap(value, 0, 1, 0, 1023);
-	this->maxMSPNetworkManager->sendBodyMessage(this->instrumentId, OscCategories::DISTANCE, "r-hand-r-knee", normalizedValue);
+	this->maxMSPNetworkManager->sendBodyMessage(soundId, MaxMSPNetworkManager::DISTANCE_R_HAND_R_KNEE, normalizedValue);
 
 	// Movements	
 	value = this->getJointNormalizedSpeed(JointType_WristLeft);
 	normalizedValue = ofMap(value, 0, 60, 0, 1023);
-	this->maxMSPNetworkManager->sendBodyMessage(this->instrumentId, OscCategories::MOVEMENT, "l-hand", normalizedValue);
+	this->maxMSPNetworkManager->sendBodyMessage(soundId, MaxMSPNetworkManager::MOVEMENT_L_HAND, normalizedValue);
 
 	value = this->getJointNormalizedSpeed(JointType_WristRight);
 	normalizedValue = ofMap(value, 0, 60, 0, 1023);
-	this->maxMSPNetworkManager->sendBodyMessage(this->instrumentId, OscCategories::MOVEMENT, "r-hand", normalizedValue);
+	this->maxMSPNetworkManager->sendBodyMessage(soundId, MaxMSPNetworkManager::MOVEMENT_R_HAND, normalizedValue);
 
 	value = this->getJointNormalizedSpeed(JointType_AnkleLeft);
 	normalizedValue = ofMap(value, 0, 60, 0, 1023);
-	this->maxMSPNetworkManager->sendBodyMessage(this->instrumentId, OscCategories::MOVEMENT, "l-foot", normalizedValue);
+	this->maxMSPNetworkManager->sendBodyMessage(soundId, MaxMSPNetworkManager::MOVEMENT_L_FOOT, normalizedValue);
 
 	value = this->getJointNormalizedSpeed(JointType_AnkleRight);
 	normalizedValue = ofMap(value, 0, 60, 0, 1023);
-	this->maxMSPNetworkManager->sendBodyMessage(this->instrumentId, OscCategories::MOVEMENT, "r-foot", normalizedValue);
+	this->maxMSPNetworkManager->sendBodyMessage(soundId, MaxMSPNetworkManager::MOVEMENT_R_FOOT, normalizedValue);
 
 	value = this->getJointNormalizedSpeed(JointType_KneeLeft);
 	normalizedValue = ofMap(value, 0, 60, 0, 1023);
-	this->maxMSPNetworkManager->sendBodyMessage(this->instrumentId, OscCategories::MOVEMENT, "l-knee", normalizedValue);
+	this->maxMSPNetworkManager->sendBodyMessage(soundId, MaxMSPNetworkManager::MOVEMENT_L_KNEE, normalizedValue);
 
 	value = this->getJointNormalizedSpeed(JointType_KneeRight);
 	normalizedValue = ofMap(value, 0, 60, 0, 1023);
-	this->maxMSPNetworkManager->sendBodyMessage(this->instrumentId, OscCategories::MOVEMENT, "r-knee", normalizedValue);
+	this->maxMSPNetworkManager->sendBodyMessage(soundId, MaxMSPNetworkManager::MOVEMENT_R_KNEE, normalizedValue);
 }
 
 // ------ Body sequencer management ------
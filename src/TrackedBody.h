@@ -4,10 +4,16 @@
 #include "ofxCv.h"
 #include "TrackedJoint.h"
 #include "GeometryUtils.h"
+#include "ContourBuffer.h"
+#include "ContourAligner.h"
+#include "ContourResampler.h"
+#include "ContourSimplifier.h"
 #include "Constants.h"
 #include "MaxMSPNetworkManager.h"
 #include "ofxVoronoi.h"
 #include "BodySoundManager.h"
+#include "GpuResourcePool.h"
+#include "BodyDataCodec.h"
 
 #ifndef TRACKED_BODY_H
 #define TRACKED_BODY_H
@@ -33,20 +39,29 @@ public:
 	static void initialize();
 
 	TrackedBody(int index, float smoothingFactor, int contourPoints = 150, int noDelayedContours = 20, bool isRemote = false);
+	virtual ~TrackedBody();
+	virtual void reset(int index);
 
 	void setOSCManager(MaxMSPNetworkManager* m);
 	void setBodySoundPlayer(BodySoundManager* bsp);
 
 	void setIsTracked(bool isTracked);
+	void releaseGpuResources();
 	void setNumberOfContourPoints(int contourPoints);
+	// Above 0, the contour sent to the peer is simplified to within this many depth pixels instead of resampled
+	void setContourTransmissionError(float transmissionError);
 
 	void setIsRecording(bool isRecording);
 	bool getIsRecording();
 
 	virtual void updateSkeletonData(map<JointType, ofxKinectForWindows2::Data::Joint> joints, ICoordinateMapper* coordinateMapper);
-	virtual void updateContourData(vector<ofPolyline> contours);
+	virtual void updateContourData(const ContourBuffer& newRawContour);
+	void updateInterpolatedContour(const ContourBuffer& newRawContour, uint32_t sequence);
 	void updateDelayedContours();
-	void deserialize(string s);
+	// Frame number at which the contour last changed.
+	// Remote bodies only change when the peer's data comes in, so later stages can skip them in between.
+	uint64_t getDataFrame();
+	void deserialize(const BodyFrame& frame);
 
 	float getJointsDistance(JointType a, JointType b);
 	float getNormalizedJointsDistance(JointType a, JointType b);
@@ -55,6 +70,7 @@ public:
 	ofVec2f getJointPosition(JointType a);
 	float getScreenRatio();
 
+	const ofPolyline& getContourPolyline();
 	pair<ofPath*, ofRectangle> getContourSegment(int start, int amount);	
 	vector<pair<JointType, ofVec2f> > getInterestPoints();
 	
@@ -72,21 +88,25 @@ public:
 	void removeInstrument();
 	void assignInstrument(int instrumentId);
 	int getInstrumentId();
+	// Site the body comes from. Instruments are numbered per site, so MaxMSP gets them namespaced by site:
+	// sound id = siteId * MAX_INSTRUMENTS + instrumentId (-1 without an instrument)
+	void setSiteId(int siteId);
+	int getSoundId();
 
 	static int instruments[Constants::MAX_INSTRUMENTS];
 	static int getFirstFreeInstrument();
 	static void acquireInstrument(int instrumentId);
 	static void releaseInstrument(int instrumentId);
 
-	string serialize();	
+	void serialize(BodyFrame& frame);
 
 	virtual void sendDataToMaxMSP();
 
 	map<JointType, ofxKinectForWindows2::Data::Joint> latestSkeleton;
 	ICoordinateMapper* coordinateMapper;
-	ofPolyline rawContour;
-	ofPolyline contour;
-	ofPath* segment;
+	ContourBuffer rawContour;
+	ContourBuffer contour;
+	ofPath segment;
 	ofImage texture;
 
 	int index;
@@ -100,12 +120,20 @@ public:
 
 protected:
 	int instrumentId;
+	int siteId;
 	int drawMode;
 	float smoothingFactor;
 	int contourPoints;
 	int noContours;
 	bool isTracked;
 	int contourIndexOffset;
+	// Frame sequence the offset was found for, interpolated frames keep their point order until the next one
+	uint32_t alignedSequence;
+	ContourAligner contourAligner;
+	ContourResampler contourResampler;
+	ContourSimplifier contourSimplifier;
+	ContourBuffer transmittedContour;
+	float transmissionError;
 	bool isRecording;
 	bool isRemote;
 	ofColor generalColor;
@@ -113,21 +141,27 @@ protected:
 
 	BodySoundManager* bodySoundPlayer;
 
+	// Joints point into jointStorage, unless a subclass points them at its own (e.g. recorded) joints
 	map<JointType, TrackedJoint*> joints;
+	map<JointType, TrackedJoint> jointStorage;
 		
 	ofPath contourPath;
-	vector<ofPolyline> delayedContours;	
+	vector<ContourBuffer> delayedContours;
+	vector<float> delayedContourSmoothings;
+
+	// ofPolyline copy of the persistent contour, for drawing & clipping
+	ofPolyline contourPolyline;
+	bool contourPolylineDirty;
+	uint64_t dataFrame;
 
 	vector < pair<pair<int, int>, float> > voronoiPoints;
 
-	ofFbo mainFbo;
-	ofFbo polyFbo;
-	ofShader speedShader;
-	ofShader vlinesShader;
-	ofShader hlinesShader;
-	ofShader gridShader;
-	ofShader fillShader;
-	ofShader dotsShader;
+	// Shared with all other bodies, owned by GpuResourcePool. The FBO is leased on first use.
+	ofFbo* polyFbo;
+	ofShader* vlinesShader;
+	ofShader* hlinesShader;
+	ofShader* gridShader;
+	ofShader* dotsShader;
 
 	map<JointType, float> JOINT_WEIGHTS;
 
@@ -1,5 +1,20 @@
 #include "TrackedBodyShadow.h"
 
+void TrackedBodyShadow::reset(int index)
+{
+	TrackedBody::reset(index);
+	this->isPlaying = false;
+	this->isRecording = false;
+	this->playhead = 0;
+	this->playDirection = 1;
+	this->trackedBodyIndex = -1;
+
+	this->recordedJoints.clear();
+	this->recordedContours.clear();
+	this->recordedRawContours.clear();
+	this->recordedTextures.clear();
+}
+
 int TrackedBodyShadow::getTrackedBodyIndex()
 {
 	return this->trackedBodyIndex;
@@ -25,6 +40,8 @@ void TrackedBodyShadow::startRecording()
 	this->isRecording = true;
 	this->isPlaying = false;
 
+	// Joints may still point into the recording we're about to clear
+	this->joints.clear();
 	this->recordedJoints.clear();
 	this->recordedContours.clear();
 	this->recordedRawContours.clear();
@@ -59,8 +76,8 @@ void TrackedBodyShadow::update()
 		TrackedBody::update();
 		if (this->contour.size() < 5) return;
 		// Record contour
-		this->recordedContours.push_back(ofPolyline(this->contour));
-		this->recordedRawContours.push_back(ofPolyline(this->rawContour));
+		this->recordedContours.push_back(this->contour);
+		this->recordedRawContours.push_back(this->rawContour);
 
 		// Record joints
 		map<JointType, TrackedJoint> newJoints;
@@ -77,6 +94,8 @@ void TrackedBodyShadow::update()
 
 		this->rawContour = this->recordedRawContours[this->playhead];
 		this->contour = this->recordedContours[this->playhead];
+		this->contourPolylineDirty = true;
+		this->dataFrame = ofGetFrameNum();
 		
 		this->joints.clear();
 		for (auto it = this->recordedJoints[this->playhead].begin(); it != this->recordedJoints[this->playhead].end(); ++it) {
@@ -101,9 +120,9 @@ void TrackedBodyShadow::updateSkeletonData(map<JointType, ofxKinectForWindows2::
 	if (this->isRecording) TrackedBody::updateSkeletonData(joints, coordinateMapper);
 }
 
-void TrackedBodyShadow::updateContourData(vector<ofPolyline> contours)
+void TrackedBodyShadow::updateContourData(const ContourBuffer& newRawContour)
 {
-	if (this->isRecording) TrackedBody::updateContourData(contours);
+	if (this->isRecording) TrackedBody::updateContourData(newRawContour);
 }
 
 void TrackedBodyShadow::sendDataToMaxMSP()
@@ -11,6 +11,8 @@ public:
 		this->playDirection = 1;
 	};
 
+	void reset(int index) override;
+
 	int getTrackedBodyIndex();
 	void setTrackedBodyIndex(int index);
 
@@ -26,7 +28,7 @@ public:
 	void update() override;
 	void draw() override;
 	void updateSkeletonData(map<JointType, ofxKinectForWindows2::Data::Joint> joints, ICoordinateMapper* coordinateMapper) override;
-	void updateContourData(vector<ofPolyline> contours) override;
+	void updateContourData(const ContourBuffer& newRawContour) override;
 	void sendDataToMaxMSP() override;
 private:
 	int playhead;
@@ -36,8 +38,8 @@ private:
 	int trackedBodyIndex;
 
 	vector<map<JointType, TrackedJoint> > recordedJoints;
-	vector<ofPolyline> recordedContours;
-	vector<ofPolyline> recordedRawContours;
+	vector<ContourBuffer> recordedContours;
+	vector<ContourBuffer> recordedRawContours;
 	vector<ofImage> recordedTextures;
 
 };
\ No newline at end of file
@@ -7,6 +7,9 @@ using namespace Constants;
 
 //--------------------------------------------------------------
 void ofApp::setup() {
+	// Logger first, the managers below log from their own threads
+	AsyncLogger::getInstance();
+
 	// Application window setup
 	int windowWidth = 2 * DEPTH_WIDTH;
 	ofSetWindowShape(windowWidth + 2 * Layout::WINDOW_PADDING, windowWidth * 3 / 4 + Layout::WINDOW_PADDING);
@@ -29,22 +32,33 @@ void ofApp::setup() {
 	// Settings panel setup
 	parametersPanelVisible = false;
 	parametersPanel.setup();
-	parametersPanel.add(bodyContourPolygonFidelity.set("Contour #points", 200, 10, 1000));
+	parametersPanel.add(bodyContourPolygonFidelity.set("Contour #points", 200, 10, Constants::MAX_CONTOUR_POINTS));
 	parametersPanel.add(automaticShadowsEnabled.set("Auto Shadows", true));	
+	parametersPanel.add(rasterIntersectionEnabled.set("Raster intersection", true));
+	parametersPanel.add(contourTransmissionError.set("Contour error (px)", Constants::CONTOUR_TRANSMISSION_ERROR, 0, 5));
+	parametersPanel.add(maskTransportEnabled.set("Send masks", false));
+	parametersPanel.add(maskTransportScale.set("Mask downsample", 2, 1, 8));
+	parametersPanel.add(jitterBufferEnabled.set("Jitter buffer", true));
+	parametersPanel.add(thumbnailCacheEpsilon.set("Thumbnail epsilon", Constants::SEQUENCER_CACHE_EPSILON, 0, 10));
+	parametersPanel.add(patternLookahead.set("Pattern lookahead (ms)", Constants::SEQUENCER_PATTERN_LOOKAHEAD_MS, 0, 500));
+	parametersPanel.add(logToConsole.set("Log to console", true));
+	parametersPanel.add(logToTextFile.set("Log to " + Constants::LOG_TEXT_FILE, false));
+	parametersPanel.add(logToBinaryFile.set("Log to " + Constants::LOG_BINARY_FILE, false));
 
 	// Networking panel setup
 	peerConnectButton.addListener(this, &ofApp::peerConnectButtonPressed);
 
 	networkPanel.setup();	
-	networkPanel.add(peerIp.set("Peer IP", Constants::CEZAR_IP));
-	networkPanel.add(peerPort.set("Peer Port", "12346"));
-	networkPanel.add(localPort.set("Local Port", "12347"));
+	networkPanel.add(siteId.set("Site ID", 0, 0, Constants::MAX_PEER_SITES - 1));
+	networkPanel.add(peerAddresses.set("Peers (ip:port, ...)", Constants::PEER_ADDRESSES));
+	networkPanel.add(localPort.set("Local Port", ofToString(Constants::PEER_PORT)));
+	networkPanel.add(relayEnabled.set("Relay (hub)", false));
 	networkPanel.add(isLeftPlayer.set("Left Side", true));
 	networkPanel.add(peerConnectButton.setup("Connect"));	
 }
 
 void ofApp::peerConnectButtonPressed() {
-	this->peerNetworkManager = new PeerNetworkManager(this->peerIp.get(), atoi(this->peerPort.get().c_str()), atoi(this->localPort.get().c_str()));
+	this->peerNetworkManager = new PeerNetworkManager(this->siteId.get(), this->peerAddresses.get(), atoi(this->localPort.get().c_str()), this->relayEnabled.get());
 	this->bodiesManager->setNetworkManagers(this->peerNetworkManager, this->maxMSPNetworkManager);
 	this->bodiesManager->setIsLeftPlayer(this->isLeftPlayer.get());
 	this->bodiesManager->setAutomaticShadowsEnabled(this->automaticShadowsEnabled.get());
@@ -53,21 +67,32 @@ void ofApp::peerConnectButtonPressed() {
 
 //--------------------------------------------------------------
 void ofApp::update() {
+	this->updateLogOutputs();
+
 	// Nothing to update before the user's hit 'Connect' to start the app.
 	if (this->peerNetworkManager == NULL) {
 		return;
 	}
 
-	this->bodiesManager->update();
+	this->bodiesManager->setRasterIntersectionEnabled(this->rasterIntersectionEnabled);
+	this->bodiesManager->setContourTransmissionError(this->contourTransmissionError);
+	this->bodiesManager->setMaskTransport(this->maskTransportEnabled, this->maskTransportScale);
 
+	// Sequencer clock first, the bodies' patterns are timed on it
+	this->maxMSPNetworkManager->getSequencerClock()->setLookahead(this->patternLookahead);
 	this->maxMSPNetworkManager->update();
 
+	this->bodiesManager->update();
+
+	this->peerNetworkManager->setJitterBufferEnabled(this->jitterBufferEnabled);
 	this->peerNetworkManager->update();
 
+	this->guiManager->setSequencerCacheEpsilon(this->thumbnailCacheEpsilon);
+	this->guiManager->setSessionStatus(ofToString(this->peerNetworkManager->getSiteId()), ofToString(this->peerNetworkManager->getConnectedPeerCount()) + " connected");
 	this->guiManager->update(
 		this->bodiesManager->getLeftBody(), 
 		this->bodiesManager->getRightBody(), 
-		this->maxMSPNetworkManager->getSequencerStep() - 1, 
+		this->maxMSPNetworkManager->getPlayingStep() - 1, 
 		this->peerNetworkManager->isConnected(),
 		this->peerNetworkManager->getLatency()
 	);	
@@ -93,7 +118,19 @@ void ofApp::draw() {
 			parametersPanel.draw();
 			stringstream ss;
 			ss << "fps : " << ofGetFrameRate() << endl;
-			ofDrawBitmapStringHighlight(ss.str(), 20, ofGetWindowHeight() - 40);
+			ss << "contour allocations : " << ContourResampler::getAllocationCount() << endl;
+			ss << "bodies live / peak / capacity : " << this->bodiesManager->getBodyPoolStats() << endl;
+			ss << "thumbnail cache hits / misses : " << SequencerStep::getCacheHits() << " / " << SequencerStep::getCacheMisses() << endl;
+			ss << "maxmsp bundles / messages : " << this->maxMSPNetworkManager->getBundlesSent() << " / " << this->maxMSPNetworkManager->getMessagesSent() << endl;
+			SequencerClock* clock = this->maxMSPNetworkManager->getSequencerClock();
+			ss << "sequencer period / drift / jitter (ms) : " << clock->getStepPeriodMs() << " / " << clock->getDriftMs() << " / " << clock->getJitterMs() << ", resyncs " << clock->getResyncs() << endl;
+			int step = this->maxMSPNetworkManager->getSequencerStep();
+			ss << "sequencer step / since (ms) : " << step << " / " << this->maxMSPNetworkManager->getTimeSinceStep(step) << endl;
+			ss << "peer traffic : " << this->peerNetworkManager->getTrafficStats() << endl;
+			// One line per peer site at the end, the text grows upwards
+			string text = ss.str();
+			int lines = count(text.begin(), text.end(), '\n');
+			ofDrawBitmapStringHighlight(text, 20, ofGetWindowHeight() - 20 - 14 * lines);
 		}
 	}
 }
@@ -150,4 +187,26 @@ void ofApp::keyPressed(int key) {
 		this->bodiesManager->clearBodyShadow(0);
 		break;
 	}
+}
+
+//--------------------------------------------------------------
+void ofApp::exit() {
+	// Write out whatever is still queued
+	AsyncLogger* logger = AsyncLogger::getInstance();
+	bool hasBinaryFile = logger->getBinaryFile() != "";
+	logger->stop();
+	if (hasBinaryFile) AsyncLogger::convertBinaryLog(Constants::LOG_BINARY_FILE, Constants::LOG_BINARY_TEXT_FILE);
+}
+
+void ofApp::updateLogOutputs() {
+	AsyncLogger* logger = AsyncLogger::getInstance();
+	logger->setConsoleEnabled(this->logToConsole);
+	logger->setTextFile(this->logToTextFile ? Constants::LOG_TEXT_FILE : "");
+	if (this->logToBinaryFile) {
+		logger->setBinaryFile(Constants::LOG_BINARY_FILE);
+	}
+	else if (logger->getBinaryFile() != "") {
+		logger->setBinaryFile("");
+		AsyncLogger::convertBinaryLog(Constants::LOG_BINARY_FILE, Constants::LOG_BINARY_TEXT_FILE);
+	}
 }
\ No newline at end of file
@@ -23,6 +23,10 @@ public:
 	void draw();
 	void drawInterface();
 	void keyPressed(int key);
+	void exit();
+
+	// Logging, set from the parameters panel
+	void updateLogOutputs();
 
 	// Networking
 	MaxMSPNetworkManager* maxMSPNetworkManager;
@@ -48,11 +52,22 @@ public:
 	ofParameter<int> bodyContourPolygonFidelity;
 	ofParameter<bool> isLeftPlayer;
 	ofParameter<bool> automaticShadowsEnabled;
+	ofParameter<bool> rasterIntersectionEnabled;
+	ofParameter<float> contourTransmissionError;
+	ofParameter<bool> maskTransportEnabled;
+	ofParameter<int> maskTransportScale;
+	ofParameter<bool> jitterBufferEnabled;
+	ofParameter<float> thumbnailCacheEpsilon;
+	ofParameter<float> patternLookahead;
+	ofParameter<bool> logToConsole;
+	ofParameter<bool> logToTextFile;
+	ofParameter<bool> logToBinaryFile;
 
 	//// Panel for app start-up: networking, connecting with peer
 	ofxPanel networkPanel;
-	ofParameter<string> peerIp;
-	ofParameter<string> peerPort;
+	ofParameter<int> siteId;
+	ofParameter<string> peerAddresses;
 	ofParameter<string> localPort;
+	ofParameter<bool> relayEnabled;
 	ofxButton peerConnectButton;
 };
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "AsyncLogger.h"
+#include "TestUtils.h"
+#include <thread>
+
+// The logger is one instance for the whole process, so this runs through its life in order: threads
+// asking for it at once, console & text output with the rate limit, a binary file converted to text,
+// and what is still queued when it stops.
+
+static const string TEXT_FILE = "AsyncLoggerTest.txt";
+static const string BINARY_FILE = "AsyncLoggerTest.bin";
+static const string CONVERTED_FILE = "AsyncLoggerTest.bin.txt";
+
+static vector<string> readLines(const string& path)
+{
+	vector<string> lines;
+	ifstream input(path.c_str());
+	string line;
+	while (getline(input, line)) lines.push_back(line);
+	return lines;
+}
+
+static bool endsWith(const string& text, const string& end)
+{
+	return text.size() >= end.size() && text.compare(text.size() - end.size(), end.size(), end) == 0;
+}
+
+static void waitForLogger()
+{
+	this_thread::sleep_for(chrono::milliseconds(50));
+}
+
+int main()
+{
+	remove(TEXT_FILE.c_str());
+	remove(BINARY_FILE.c_str());
+	remove(CONVERTED_FILE.c_str());
+
+	// Built once, whichever thread gets there first
+	AsyncLogger* loggers[4];
+	vector<thread> threads;
+	for (int i = 0; i < 4; i++) {
+		threads.push_back(thread([&loggers, i] {
+			loggers[i] = AsyncLogger::getInstance();
+			LOG_NOTICE("Thread {} started", i);
+		}));
+	}
+	for (auto& t : threads) t.join();
+	AsyncLogger* logger = AsyncLogger::getInstance();
+	for (int i = 0; i < 4; i++) CHECK(loggers[i] == logger);
+	waitForLogger();
+	CHECK(ofLog::messageCount() == 4);
+
+	// Console & text file: 5 of the 50 repeats go out, the rest is summed up once their second is over
+	logger->setTextFile(TEXT_FILE);
+	logger->setTextFile(TEXT_FILE);
+	int console = ofLog::messageCount();
+	for (int i = 0; i < 50; i++) LOG_NOTICE("Repeated {} of {}", i, "fifty");
+	LOG_WARNING("Ratio {} is {}", 2.5, string("odd"));
+	waitForLogger();
+	CHECK(ofLog::messageCount() - console == AsyncLogger::RATE_LIMIT + 1);
+	this_thread::sleep_for(chrono::milliseconds(1200));
+	CHECK(ofLog::messageCount() - console == AsyncLogger::RATE_LIMIT + 2);
+
+	vector<string> lines = readLines(TEXT_FILE);
+	CHECK(lines.size() == AsyncLogger::RATE_LIMIT + 2);
+	if (lines.size() == AsyncLogger::RATE_LIMIT + 2) {
+		CHECK(endsWith(lines[0], "[notice] Repeated 0 of fifty"));
+		CHECK(endsWith(lines[AsyncLogger::RATE_LIMIT - 1], "[notice] Repeated 4 of fifty"));
+		CHECK(endsWith(lines[AsyncLogger::RATE_LIMIT], "[warning] Ratio 2.5 is odd"));
+		CHECK(endsWith(lines[AsyncLogger::RATE_LIMIT + 1], "[notice] Repeated 49 of fifty (45 similar messages suppressed)"));
+	}
+
+	// Binary file, console and text off: nothing is formatted until it's converted. Setting the same file
+	// again keeps what was written so far
+	logger->setConsoleEnabled(false);
+	logger->setTextFile("");
+	console = ofLog::messageCount();
+	logger->setBinaryFile(BINARY_FILE);
+	CHECK(logger->getBinaryFile() == BINARY_FILE);
+	LOG_ERROR("Body {} at {}, {}", 7, 1.25f, "left");
+	waitForLogger();
+	logger->setBinaryFile(BINARY_FILE);
+	const string longText(200, 'x');
+	for (int i = 0; i < 10; i++) LOG_NOTICE("Long {} {}", i, longText);
+	LOG_NOTICE("Queued at the end {}", -3);
+
+	// Stop writes out whatever is still queued and closes the files
+	logger->stop();
+	CHECK(logger->getBinaryFile() == "");
+	CHECK(ofLog::messageCount() == console);
+	CHECK(readLines(TEXT_FILE).size() == AsyncLogger::RATE_LIMIT + 2);
+
+	CHECK(AsyncLogger::convertBinaryLog(BINARY_FILE, CONVERTED_FILE));
+	lines = readLines(CONVERTED_FILE);
+	CHECK(lines.size() == 12);
+	if (lines.size() == 12) {
+		CHECK(endsWith(lines[0], "[error] Body 7 at 1.25, left"));
+		// Strings are cut to what fits in a record, every record is kept (the rate limit is only for text)
+		CHECK(endsWith(lines[1], "[notice] Long 0 " + longText.substr(0, AsyncLogger::STRING_BYTES - 1)));
+		CHECK(endsWith(lines[10], "[notice] Long 9 " + longText.substr(0, AsyncLogger::STRING_BYTES - 1)));
+		CHECK(endsWith(lines[11], "[notice] Queued at the end -3"));
+	}
+	// Anything else isn't a binary log
+	CHECK(!AsyncLogger::convertBinaryLog(TEXT_FILE, CONVERTED_FILE));
+
+	return TEST_RESULT();
+}
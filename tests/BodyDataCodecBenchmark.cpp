@@ -0,0 +1,198 @@
+#include "BodyDataCodec.h"
+#include "TestUtils.h"
+
+// Size and speed of the peer body messages: the text format bodies were sent in before BodyDataCodec,
+// against the binary one with keyframes only and with the usual deltas in between.
+// A body with every joint and a 150 point contour, standing in place and waving an arm.
+// Prints its numbers, and checks sizes and what comes back out (timings depend on the machine).
+
+static const int FRAMES = 300;
+static const int PASSES = 5;
+static const int POINTS = 150;
+
+static void captureFrame(int frameNum, BodyFrame& frame)
+{
+	const float x = 250, y = 200;
+	frame.clear();
+	frame.index = 2;
+	frame.instrumentId = 4;
+	frame.captureTime = frameNum * 33;
+	for (int joint = 0; joint < JointType_Count; joint++) {
+		frame.setJoint((JointType)joint, ofVec2f(x + 3 * joint - 36, y + 7 * joint - 90 + sin(frameNum * 0.1 + joint)));
+	}
+	// Most of the outline holds still from one frame to the next
+	for (int i = 0; i < POINTS; i++) {
+		float angle = i * TWO_PI / POINTS;
+		float radius = 80 + 10 * sin(angle * 3);
+		if (i > 20 && i < 40) radius += 15 * sin(frameNum * 0.2);
+		frame.contour.addPoint(x + 0.5 * radius * cos(angle), y + radius * sin(angle));
+	}
+}
+
+// The format TrackedBody::serialize() used to send
+static string encodeText(const BodyFrame& frame)
+{
+	stringstream ss;
+	ss << frame.index << "\n";
+	ss << "__SKELETON__" << "\n";
+	ss << JointType_Count << "\n";
+	for (int joint = 0; joint < JointType_Count; joint++) {
+		ss << joint << " " << frame.joints[joint].x << " " << frame.joints[joint].y << "\n";
+	}
+	ss << "__CONTOUR__" << "\n";
+	ss << frame.contour.size() << "\n";
+	for (int i = 0; i < frame.contour.size(); i++) {
+		ss << frame.contour.getX()[i] << " " << frame.contour.getY()[i] << "\n";
+	}
+	ss << "__IS_RECORDING__" << "\n";
+	ss << (int)frame.isRecording << "\n";
+	ss << "__INSTRUMENT_ID__" << "\n";
+	ss << frame.instrumentId;
+	return ss.str();
+}
+
+static void decodeText(const string& s, BodyFrame& frame)
+{
+	istringstream ss(s);
+	string delimiter;
+	int joints, joint, points, isRecording;
+	float x, y;
+	frame.clear();
+	ss >> frame.index >> delimiter >> joints;
+	for (int i = 0; i < joints; i++) {
+		ss >> joint >> x >> y;
+		frame.setJoint((JointType)joint, ofVec2f(x, y));
+	}
+	ss >> delimiter >> points;
+	for (int i = 0; i < points; i++) {
+		ss >> x >> y;
+		frame.contour.addPoint(x, y);
+	}
+	ss >> delimiter >> isRecording >> delimiter >> frame.instrumentId;
+	frame.isRecording = isRecording != 0;
+}
+
+// Largest distance from a point of the sent contour to the closest point of the received one
+static float getContourError(const ContourBuffer& sent, const ContourBuffer& received)
+{
+	float error = 0;
+	for (int i = 0; i < sent.size(); i++) {
+		float closest = 1e9;
+		for (int j = 0; j < received.size(); j++) {
+			closest = min(closest, sent.getPoint(i).distance(received.getPoint(j)));
+		}
+		error = max(error, closest);
+	}
+	return error;
+}
+
+static float getJointError(const BodyFrame& sent, const BodyFrame& received)
+{
+	float error = 0;
+	for (int joint = 0; joint < JointType_Count; joint++) {
+		if (!received.hasJoint(joint)) return 1e9;
+		error = max(error, sent.joints[joint].distance(received.joints[joint]));
+	}
+	return error;
+}
+
+struct Result {
+	double bytes;
+	double encodeMicros;
+	double decodeMicros;
+	float jointError;
+	float contourError;
+};
+
+static void print(const string& name, const Result& result)
+{
+	printf("%-16s %8.0f bytes %8.2f us encode %8.2f us decode, error joints %.3f contour %.3f px\n",
+		name.c_str(), result.bytes, result.encodeMicros, result.decodeMicros, result.jointError, result.contourError);
+}
+
+static Result runText(const vector<BodyFrame>& frames)
+{
+	Result result = {};
+	vector<string> messages(frames.size());
+	BodyFrame received;
+
+	uint64_t start = ofGetElapsedTimeMicros();
+	for (int pass = 0; pass < PASSES; pass++) {
+		for (int i = 0; i < frames.size(); i++) messages[i] = encodeText(frames[i]);
+	}
+	result.encodeMicros = (double)(ofGetElapsedTimeMicros() - start) / (PASSES * frames.size());
+
+	start = ofGetElapsedTimeMicros();
+	for (int pass = 0; pass < PASSES; pass++) {
+		for (int i = 0; i < frames.size(); i++) decodeText(messages[i], received);
+	}
+	result.decodeMicros = (double)(ofGetElapsedTimeMicros() - start) / (PASSES * frames.size());
+
+	for (int i = 0; i < frames.size(); i++) {
+		result.bytes += messages[i].size();
+		decodeText(messages[i], received);
+		result.jointError = max(result.jointError, getJointError(frames[i], received));
+		result.contourError = max(result.contourError, getContourError(frames[i].contour, received.contour));
+	}
+	result.bytes /= frames.size();
+	return result;
+}
+
+static Result runBinary(const vector<BodyFrame>& frames, int keyframeInterval)
+{
+	Result result = {};
+	vector<ofBuffer> messages(frames.size());
+	BodyFrame received;
+
+	// Every pass on fresh codecs, so they go through the same keyframes and deltas
+	uint64_t encodeTime = 0, decodeTime = 0;
+	for (int pass = 0; pass < PASSES; pass++) {
+		BodyDataCodec encoder, decoder;
+		encoder.setKeyframeInterval(keyframeInterval);
+
+		uint64_t start = ofGetElapsedTimeMicros();
+		for (int i = 0; i < frames.size(); i++) encoder.encode(frames[i], messages[i]);
+		encodeTime += ofGetElapsedTimeMicros() - start;
+
+		start = ofGetElapsedTimeMicros();
+		for (int i = 0; i < frames.size(); i++) CHECK(decoder.decode(messages[i], received));
+		decodeTime += ofGetElapsedTimeMicros() - start;
+		CHECK(decoder.getDecodeErrors() == 0);
+	}
+	result.encodeMicros = (double)encodeTime / (PASSES * frames.size());
+	result.decodeMicros = (double)decodeTime / (PASSES * frames.size());
+
+	BodyDataCodec decoder;
+	for (int i = 0; i < frames.size(); i++) {
+		result.bytes += messages[i].size();
+		CHECK(decoder.decode(messages[i], received));
+		CHECK(received.index == frames[i].index && received.instrumentId == frames[i].instrumentId);
+		CHECK(received.contour.size() == frames[i].contour.size());
+		result.jointError = max(result.jointError, getJointError(frames[i], received));
+		result.contourError = max(result.contourError, getContourError(frames[i].contour, received.contour));
+	}
+	result.bytes /= frames.size();
+	return result;
+}
+
+int main()
+{
+	vector<BodyFrame> frames(FRAMES);
+	for (int i = 0; i < FRAMES; i++) captureFrame(i, frames[i]);
+
+	Result text = runText(frames);
+	Result keyframes = runBinary(frames, 1);
+	Result deltas = runBinary(frames, Constants::PEER_KEYFRAME_INTERVAL);
+	print("text", text);
+	print("binary keyframes", keyframes);
+	print("binary deltas", deltas);
+
+	CHECK(keyframes.bytes * 4 < text.bytes);
+	CHECK(deltas.bytes * 2 < keyframes.bytes);
+	// Quantized to 1 / COORDINATE_SCALE of a pixel
+	const float quantization = 1.0 / BodyDataCodec::COORDINATE_SCALE;
+	CHECK(keyframes.jointError <= quantization && keyframes.contourError <= quantization);
+	CHECK(deltas.jointError <= quantization && deltas.contourError <= quantization);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,143 @@
+#include "BodyJitterBuffer.h"
+#include "BodyDataCodec.h"
+#include "TestUtils.h"
+#include <random>
+
+// Loopback: a body moving along a sine is encoded every 3rd frame, sent over a link which loses,
+// delays and reorders messages, decoded and played back through the jitter buffer at 60 fps.
+
+struct Message {
+	double arrivalTime;
+	ofBuffer buffer;
+};
+
+static const float RADIUS = 50;
+static const int POINTS = 100;
+// Sender clock, close to wrapping around
+static const uint32_t SENDER_CLOCK_OFFSET = 4294960000u;
+
+static float getTrueX(double senderTime)
+{
+	return 200 + 100 * sin(senderTime / 1000.0 * 2);
+}
+
+static void captureFrame(double now, BodyFrame& frame)
+{
+	float x = getTrueX(now);
+	frame.clear();
+	frame.index = 0;
+	frame.instrumentId = 3;
+	frame.captureTime = SENDER_CLOCK_OFFSET + (uint32_t)now;
+	frame.setJoint(JointType_Head, ofVec2f(x, 200));
+	for (int i = 0; i < POINTS; i++) {
+		frame.contour.addPoint(x + RADIUS * cos(i * TWO_PI / POINTS), 200 + RADIUS * sin(i * TWO_PI / POINTS));
+	}
+}
+
+static double getSenderTime(const BodyFrame& frame)
+{
+	return (double)(uint32_t)(frame.captureTime - SENDER_CLOCK_OFFSET);
+}
+
+int main()
+{
+	mt19937 random(1);
+	uniform_real_distribution<double> uniform(0, 1);
+
+	BodyDataCodec encoder, decoder;
+	BodyJitterBuffer jitterBuffer;
+	BodyFrame captured, received, output;
+	vector<Message> inFlight;
+	uint32_t newestSequence = 0;
+
+	const double frameTime = 1000.0 / 60;
+	const double sendUntil = 20000;
+	int frames = 0, sent = 0, delivered = 0, samples = 0, interpolated = 0, heldSamples = 0;
+	double errorSum = 0, errorMax = 0;
+	int errorCount = 0;
+	bool hasPrevious = false;
+	uint32_t previousCaptureTime = 0, previousSequence = 0;
+
+	for (double now = 0; now < sendUntil + 2000; now += frameTime) {
+		frames++;
+
+		// Sender: every 3rd frame, 10% lost, 30-70ms transit with the odd 120ms spike
+		if (now < sendUntil && frames % 3 == 0) {
+			captureFrame(now, captured);
+			Message message;
+			encoder.encode(captured, message.buffer);
+			sent++;
+			if (uniform(random) > 0.1) {
+				double transit = 30 + 40 * uniform(random) * uniform(random) + (uniform(random) < 0.05 ? 120 : 0);
+				message.arrivalTime = now + transit;
+				inFlight.push_back(message);
+			}
+		}
+
+		// Receiver: whatever arrived by now, in arrival order, stale ones dropped the way the peer manager does
+		sort(inFlight.begin(), inFlight.end(), [](const Message& a, const Message& b) { return a.arrivalTime < b.arrivalTime; });
+		while (inFlight.size() > 0 && inFlight[0].arrivalTime <= now) {
+			int index;
+			uint32_t sequence;
+			bool isNewer = BodyDataCodec::peekSequence(inFlight[0].buffer, index, sequence) && (int32_t)(sequence - newestSequence) > 0;
+			if (isNewer && decoder.decode(inFlight[0].buffer, received)) {
+				newestSequence = sequence;
+				CHECK(!received.isInterpolated);
+				jitterBuffer.push(received, (uint64_t)(1000000 + now));
+				delivered++;
+			}
+			inFlight.erase(inFlight.begin());
+		}
+
+		if (!jitterBuffer.sample((uint64_t)(1000000 + now), output)) continue;
+		samples++;
+		if (output.isInterpolated) interpolated++;
+		if (now >= sendUntil + 1000) heldSamples++;
+
+		// A sample is only reported when it changed, and playout never goes back in time
+		if (hasPrevious) {
+			CHECK(output.captureTime != previousCaptureTime || output.sequence != previousSequence);
+			CHECK((int32_t)(output.captureTime - previousCaptureTime) >= 0);
+		}
+		hasPrevious = true;
+		previousCaptureTime = output.captureTime;
+		previousSequence = output.sequence;
+
+		// Nothing to ask of the first second, the playout delay is still settling
+		if (now < 1000) continue;
+		const double senderTime = getSenderTime(output);
+		const float trueX = getTrueX(senderTime);
+		CHECK(output.hasJoint(JointType_Head));
+		double error = fabs(output.joints[JointType_Head].x - trueX);
+		errorSum += error;
+		errorMax = max(errorMax, error);
+		errorCount++;
+
+		// The contour is still the circle, around the same center as the joint
+		CHECK(output.contour.size() >= POINTS / 2);
+		for (int i = 0; i < output.contour.size(); i++) {
+			ofVec2f point = output.contour.getPoint(i);
+			float radius = point.distance(output.joints[JointType_Head]);
+			CHECK(fabs(radius - RADIUS) < 2);
+		}
+	}
+
+	// Same time again: nothing new to play
+	CHECK(!jitterBuffer.sample((uint64_t)(1000000 + sendUntil + 2000), output));
+
+	const double errorMean = errorSum / max(errorCount, 1);
+	printf("frames %d, sent %d, delivered %d, samples %d (%d interpolated, %d held)\n", frames, sent, delivered, samples, interpolated, heldSamples);
+	printf("joint error mean %.3f max %.3f px, playout delay %.1f ms, jitter %.1f ms, late %d\n",
+		errorMean, errorMax, jitterBuffer.getPlayoutDelay(), jitterBuffer.getJitter(), jitterBuffer.getLateFrames());
+
+	CHECK(delivered < sent);
+	// Played out on (almost) every frame, and most of it interpolated between two received frames
+	CHECK(samples > frames * 8 / 10);
+	CHECK(interpolated > samples / 2);
+	// Once the sender stopped, the body holds still instead of being reported as changed
+	CHECK(heldSamples == 0);
+	CHECK(errorMean < 1.0);
+	CHECK(errorMax < 20.0);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,94 @@
+#include "GpuResourcePool.h"
+#include "TestUtils.h"
+
+// The pool's bookkeeping, through a backend which counts what would have gone to the GPU
+
+class CountingBackend : public GpuResourceBackend {
+public:
+	bool loadShader(ofShader& shader, const string& path) {
+		this->shaderLoads[path]++;
+		return path != "shaders_gl3/missing";
+	}
+	void allocateFbo(ofFbo& fbo, int width, int height) {
+		fbo.allocate(width, height);
+		this->fboAllocations++;
+	}
+
+	map<string, int> shaderLoads;
+	int fboAllocations = 0;
+};
+
+int main()
+{
+	AsyncLogger::getInstance()->setConsoleEnabled(true);
+	ofLog::printLevel() = OF_LOG_SILENT;
+
+	CountingBackend backend;
+	GpuResourcePool* pool = GpuResourcePool::getInstance();
+	CHECK(pool == GpuResourcePool::getInstance());
+	pool->setBackend(&backend);
+
+	// Start-up: every shader compiled once, the FBOs allocated and back in the pool
+	pool->preload({ "outline", "glow", "outline" }, 512, 424, 3);
+	CHECK(pool->getShaderCount() == 2);
+	CHECK(backend.shaderLoads["shaders_gl3/outline"] == 1);
+	CHECK(backend.shaderLoads["shaders_gl3/glow"] == 1);
+	CHECK(pool->getFboCount() == 3);
+	CHECK(backend.fboAllocations == 3);
+	CHECK(pool->getLeasedFboCount() == 0);
+
+	// Bodies share the one instance
+	ofShader* outline = pool->getShader("outline");
+	CHECK(outline == pool->getShader("outline"));
+	CHECK(outline != pool->getShader("glow"));
+	CHECK(backend.shaderLoads["shaders_gl3/outline"] == 1);
+
+	// A shader which doesn't load is reported once and not tried again
+	const int errors = ofLog::messageCount();
+	ofShader* missing = pool->getShader("missing");
+	CHECK(missing != NULL);
+	CHECK(missing == pool->getShader("missing"));
+	CHECK(backend.shaderLoads["shaders_gl3/missing"] == 1);
+	CHECK(ofLog::messageCount() == errors + 1);
+
+	// Leases come out of the preloaded FBOs, the pool only grows past them
+	vector<ofFbo*> leased;
+	for (int i = 0; i < 3; i++) leased.push_back(pool->acquireFbo(512, 424));
+	CHECK(backend.fboAllocations == 3);
+	CHECK(pool->getLeasedFboCount() == 3);
+	CHECK(leased[0] != leased[1] && leased[1] != leased[2] && leased[0] != leased[2]);
+	ofFbo* extra = pool->acquireFbo(512, 424);
+	CHECK(backend.fboAllocations == 4);
+	CHECK(pool->getFboCount() == 4);
+
+	// Sizes aren't mixed up
+	ofFbo* small = pool->acquireFbo(256, 212);
+	CHECK(backend.fboAllocations == 5);
+	CHECK(small->getWidth() == 256 && small->getHeight() == 212);
+
+	// A released FBO is the next one handed out, releasing it twice doesn't count twice
+	pool->releaseFbo(leased[1]);
+	pool->releaseFbo(leased[1]);
+	CHECK(pool->getLeasedFboCount() == 4);
+	CHECK(pool->acquireFbo(512, 424) == leased[1]);
+	CHECK(pool->getLeasedFboCount() == 5);
+	pool->releaseFbo(small);
+	CHECK(pool->acquireFbo(512, 424) != small);
+	CHECK(pool->acquireFbo(256, 212) == small);
+	CHECK(backend.fboAllocations == 6);
+
+	// Nothing happens to an FBO the pool doesn't know, besides a warning. NULL is fine
+	ofFbo stranger;
+	const int leasedCount = pool->getLeasedFboCount();
+	const int warnings = ofLog::messageCount();
+	pool->releaseFbo(&stranger);
+	pool->releaseFbo(NULL);
+	CHECK(pool->getLeasedFboCount() == leasedCount);
+	AsyncLogger::getInstance()->stop();
+	CHECK(ofLog::messageCount() == warnings + 1);
+
+	for (auto fbo : leased) pool->releaseFbo(fbo);
+	pool->releaseFbo(extra);
+	pool->setBackend(NULL);
+	return TEST_RESULT();
+}
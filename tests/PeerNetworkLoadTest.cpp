@@ -0,0 +1,139 @@
+#include "PeerNetworkManager.h"
+#include "TestUtils.h"
+
+// Six sites on the in-process network (stubs/ofxOsc.h), each sending six bodies at 30 fps, one of them
+// large enough to go out in fragments. Site 0 is a hub which relays; the others only list some addresses:
+//   0: itself, under an address it doesn't receive from
+//   1, 2: the hub and each other, so their bodies reach each other directly and through the hub
+//   3: the hub twice, under two addresses
+//   4: the hub and itself under another address
+//   5: the hub
+// Every site has to end up with every other site's bodies, nobody sends to itself, a site listed twice
+// only gets everything once, and the hub passes each message on once.
+
+static const int SITES = 6;
+static const int BODIES = 6;
+static const int BASE_PORT = 21000;
+
+static void captureFrame(int index, uint64_t frame, BodyFrame& output)
+{
+	// Body 5 is a detailed silhouette, sent in fragments
+	const int points = (index == BODIES - 1) ? 900 : 150;
+	const float x = 100 + 40 * index + 20 * sin(frame * 0.05);
+	output.clear();
+	output.index = index;
+	output.instrumentId = index;
+	output.captureTime = (uint32_t)ofGetSystemTimeMillis();
+	output.setJoint(JointType_Head, ofVec2f(x, 100));
+	for (int i = 0; i < points; i++) {
+		float angle = i * TWO_PI / points;
+		float radius = 30 + ((index == BODIES - 1) ? 4 * sin(i * 1.7 + frame * 0.3) : 0);
+		output.contour.addPoint(x + radius * cos(angle), 150 + radius * sin(angle));
+	}
+}
+
+static int getBodyMessages(int site, int origin)
+{
+	ofxOscTestNetwork& network = ofxOscTestNetwork::get();
+	return network.getDeliveries(BASE_PORT + site, OscCategories::REMOTE_BODY_DATA, origin) +
+		network.getDeliveries(BASE_PORT + site, OscCategories::REMOTE_BODY_FRAGMENT, origin);
+}
+
+static bool isAbout(int value, int expected)
+{
+	return value >= expected * 0.9 && value <= expected * 1.1;
+}
+
+int main()
+{
+	AsyncLogger::getInstance()->setConsoleEnabled(false);
+
+	const string hub = "10.0.0.1:" + ofToString(BASE_PORT);
+	const string addresses[SITES] = {
+		"192.168.1.10:" + ofToString(BASE_PORT),
+		hub + ", 10.0.0.3:" + ofToString(BASE_PORT + 2),
+		hub + ", 10.0.0.2:" + ofToString(BASE_PORT + 1),
+		hub + ", hub.local:" + ofToString(BASE_PORT),
+		hub + ", 10.0.0.5:" + ofToString(BASE_PORT + 4),
+		"hub.local:" + ofToString(BASE_PORT)
+	};
+
+	vector<PeerNetworkManager*> sites;
+	for (int i = 0; i < SITES; i++) {
+		sites.push_back(new PeerNetworkManager(i, addresses[i], BASE_PORT + i, i == 0));
+	}
+
+	BodyFrame frame;
+	const uint64_t start = ofGetElapsedTimeMillis();
+	bool isWarm = false;
+	uint64_t frameNum = 0;
+	while (ofGetElapsedTimeMillis() - start < 4000) {
+		// Links know their sites after the first pings, only the traffic from then on is counted
+		if (!isWarm && ofGetElapsedTimeMillis() - start >= 1000) {
+			ofxOscTestNetwork::get().resetDeliveries();
+			isWarm = true;
+		}
+
+		frameNum++;
+		ofTestFrameNum() = frameNum;
+		for (int site = 0; site < SITES; site++) {
+			if (frameNum % 2 == 0) {
+				for (int body = 0; body < BODIES; body++) {
+					captureFrame(body, frameNum, frame);
+					sites[site]->sendBodyData(body, frame);
+				}
+			}
+			sites[site]->update();
+		}
+		this_thread::sleep_for(chrono::milliseconds(16));
+	}
+
+	// Every site has every other site's bodies, with recent data
+	const uint32_t now = (uint32_t)ofGetSystemTimeMillis();
+	for (int site = 0; site < SITES; site++) {
+		for (int origin = 0; origin < SITES; origin++) {
+			for (int body = 0; body < BODIES; body++) {
+				const int id = origin * PeerNetworkManager::SITE_BODY_IDS + body;
+				if (origin == site) {
+					CHECK(sites[site]->getBodyData(id) == NULL);
+					continue;
+				}
+				CHECK(sites[site]->isBodyActive(id));
+				const BodyFrame* data = sites[site]->getBodyData(id);
+				CHECK(data != NULL);
+				if (data == NULL) continue;
+				CHECK((int32_t)(now - data->captureTime) < 750);
+				CHECK(data->contour.size() > 0);
+			}
+		}
+	}
+
+	ofxOscTestNetwork& network = ofxOscTestNetwork::get();
+	for (int site = 0; site < SITES; site++) {
+		// Nothing sent to ourselves, whatever address we were listed under
+		CHECK(getBodyMessages(site, site) == 0);
+		CHECK(network.getDeliveries(BASE_PORT + site, OscCategories::PEER_PING, site) == 0);
+	}
+
+	// Site 3 lists the hub twice but sends & pings it as much as site 5, which lists it once
+	const int singleLink = getBodyMessages(0, 5);
+	CHECK(singleLink > 0);
+	CHECK(isAbout(getBodyMessages(0, 3), singleLink));
+	CHECK(isAbout(network.getDeliveries(BASE_PORT, OscCategories::PEER_PING, 3), network.getDeliveries(BASE_PORT, OscCategories::PEER_PING, 5)));
+
+	// The hub passes every message on once, to every site but the one it came from: nothing bounces back,
+	// and site 2 gets site 1's bodies once directly & once relayed
+	const int fromSite1 = getBodyMessages(0, 1);
+	CHECK(isAbout(fromSite1, singleLink));
+	CHECK(isAbout(getBodyMessages(4, 1), fromSite1));
+	CHECK(isAbout(getBodyMessages(5, 1), fromSite1));
+	CHECK(isAbout(getBodyMessages(2, 1), 2 * fromSite1));
+	CHECK(getBodyMessages(1, 1) == 0);
+
+	printf("body messages to the hub per site: %d, relayed from site 1 to site 4: %d, to site 2: %d\n",
+		singleLink, getBodyMessages(4, 1), getBodyMessages(2, 1));
+	printf("%s\n", sites[2]->getTrafficStats().c_str());
+
+	for (auto site : sites) delete site;
+	return TEST_RESULT();
+}
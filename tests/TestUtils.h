@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdio>
+
+// Failed checks are printed and counted, the test's main() returns TEST_RESULT()
+static int testFailures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			testFailures++; \
+		} \
+	} while (0)
+
+#define TEST_RESULT() (testFailures == 0 ? 0 : 1)
@@ -0,0 +1,198 @@
+#pragma once
+
+// Just enough of openFrameworks for the tests to build the app's classes without a window or a device.
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <deque>
+#include <list>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+#define PI 3.14159265358979323846
+#define TWO_PI 6.28318530717958647693
+
+namespace glm {
+	struct vec3 {
+		float x, y, z;
+		vec3(float x = 0, float y = 0, float z = 0) : x(x), y(y), z(z) {}
+	};
+}
+
+class ofVec2f {
+public:
+	float x, y;
+	ofVec2f(float x = 0, float y = 0) : x(x), y(y) {}
+	ofVec2f operator+(const ofVec2f& v) const { return ofVec2f(x + v.x, y + v.y); }
+	ofVec2f operator-(const ofVec2f& v) const { return ofVec2f(x - v.x, y - v.y); }
+	ofVec2f operator*(float f) const { return ofVec2f(x * f, y * f); }
+	ofVec2f operator/(float f) const { return ofVec2f(x / f, y / f); }
+	float squareDistance(const ofVec2f& v) const { return (x - v.x) * (x - v.x) + (y - v.y) * (y - v.y); }
+	float distance(const ofVec2f& v) const { return sqrt(this->squareDistance(v)); }
+	float length() const { return sqrt(x * x + y * y); }
+};
+
+class ofColor {
+public:
+	unsigned char r, g, b, a;
+	ofColor(int r = 0, int g = 0, int b = 0, int a = 255) : r(r), g(g), b(b), a(a) {}
+};
+
+class ofPolyline {
+public:
+	void addVertex(float x, float y) { this->vertices.push_back(glm::vec3(x, y)); }
+	void clear() { this->vertices.clear(); }
+	void close() {}
+	size_t size() const { return this->vertices.size(); }
+	const glm::vec3& operator[](int i) const { return this->vertices[i]; }
+private:
+	vector<glm::vec3> vertices;
+};
+
+enum ofPixelFormat { OF_PIXELS_GRAY = 1, OF_PIXELS_RGB = 3, OF_PIXELS_RGBA = 4 };
+
+class ofPixels {
+public:
+	void allocate(size_t width, size_t height, size_t channels) { this->width = width; this->height = height; this->channels = channels; this->data.assign(width * height * channels, 0); }
+	void allocate(size_t width, size_t height, ofPixelFormat format) { this->allocate(width, height, (size_t)format); }
+	void set(unsigned char value) { std::fill(this->data.begin(), this->data.end(), value); }
+	unsigned char* getData() { return this->data.data(); }
+	const unsigned char* getData() const { return this->data.data(); }
+	size_t getWidth() const { return this->width; }
+	size_t getHeight() const { return this->height; }
+	size_t getNumChannels() const { return this->channels; }
+private:
+	vector<unsigned char> data;
+	size_t width = 0, height = 0, channels = 1;
+};
+
+// No GL context here: nothing loads or allocates, the GPU resource pool's tests use their own backend
+class ofShader {
+public:
+	bool load(const string& path) { return false; }
+};
+
+class ofFbo {
+public:
+	void allocate(int width, int height) { this->width = width; this->height = height; }
+	float getWidth() const { return this->width; }
+	float getHeight() const { return this->height; }
+private:
+	int width = 0, height = 0;
+};
+
+class ofBuffer {
+public:
+	ofBuffer() {}
+	ofBuffer(const char* data, size_t size) : data(data, data + size) {}
+	void set(const char* data, size_t size) { this->data.assign(data, data + size); }
+	void append(const char* data, size_t size) { this->data.insert(this->data.end(), data, data + size); }
+	void allocate(size_t size) { this->data.resize(size); }
+	void clear() { this->data.clear(); }
+	char* getData() { return this->data.data(); }
+	const char* getData() const { return this->data.data(); }
+	size_t size() const { return this->data.size(); }
+private:
+	vector<char> data;
+};
+
+inline float ofClamp(float value, float min, float max) { return value < min ? min : value > max ? max : value; }
+inline float ofMap(float value, float inputMin, float inputMax, float outputMin, float outputMax, bool clamp = false)
+{
+	float result = outputMin + (value - inputMin) / (inputMax - inputMin) * (outputMax - outputMin);
+	return clamp ? ofClamp(result, min(outputMin, outputMax), max(outputMin, outputMax)) : result;
+}
+
+inline uint64_t ofGetElapsedTimeMicros()
+{
+	static const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+}
+inline uint64_t ofGetElapsedTimeMillis() { return ofGetElapsedTimeMicros() / 1000; }
+inline uint64_t ofGetSystemTimeMillis() { return chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count(); }
+inline uint64_t ofGetSystemTimeMicros() { return chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count(); }
+// Tests step the frame counter themselves
+inline uint64_t& ofTestFrameNum() { static uint64_t frameNum = 0; return frameNum; }
+inline uint64_t ofGetFrameNum() { return ofTestFrameNum(); }
+
+template <typename T> string ofToString(const T& value) { ostringstream out; out << value; return out.str(); }
+inline int ofToInt(const string& value) { return atoi(value.c_str()); }
+inline vector<string> ofSplitString(const string& source, const string& delimiter, bool ignoreEmpty = false, bool trim = false)
+{
+	vector<string> result;
+	size_t start = 0;
+	while (start <= source.size()) {
+		size_t end = source.find(delimiter, start);
+		if (end == string::npos) end = source.size();
+		string part = source.substr(start, end - start);
+		if (trim) {
+			size_t first = part.find_first_not_of(" \t");
+			size_t last = part.find_last_not_of(" \t");
+			part = (first == string::npos) ? "" : part.substr(first, last - first + 1);
+		}
+		if (!ignoreEmpty || !part.empty()) result.push_back(part);
+		start = end + delimiter.size();
+	}
+	return result;
+}
+inline string ofToDataPath(const string& path, bool absolute = false) { return path; }
+
+enum ofLogLevel { OF_LOG_VERBOSE, OF_LOG_NOTICE, OF_LOG_WARNING, OF_LOG_ERROR, OF_LOG_FATAL_ERROR, OF_LOG_SILENT };
+
+// Console output is counted (tests check what reached it) and only printed below OF_LOG_SILENT
+class ofLog {
+public:
+	ofLog(ofLogLevel level = OF_LOG_NOTICE) : level(level) {}
+	ofLog(ofLogLevel level, const string& message) : level(level) { this->out << message; }
+	~ofLog() {
+		ofLog::messageCount()++;
+		if (this->level >= ofLog::printLevel()) cout << this->out.str() << endl;
+	}
+	template <typename T> ofLog& operator<<(const T& value) { this->out << value; return *this; }
+	static atomic<int>& messageCount() { static atomic<int> count(0); return count; }
+	static ofLogLevel& printLevel() { static ofLogLevel level = OF_LOG_WARNING; return level; }
+private:
+	ofLogLevel level;
+	ostringstream out;
+};
+inline ofLog ofLogError() { return ofLog(OF_LOG_ERROR); }
+
+class ofThread {
+public:
+	ofThread() : running(false) {}
+	virtual ~ofThread() { this->waitForThread(true); }
+	void startThread() {
+		this->running = true;
+		this->thread = std::thread([this] { this->threadedFunction(); });
+	}
+	void stopThread() { this->running = false; }
+	bool isThreadRunning() const { return this->running; }
+	void waitForThread(bool callStopThread = true, long milliseconds = -1) {
+		if (callStopThread) this->stopThread();
+		if (this->thread.joinable() && this->thread.get_id() != this_thread::get_id()) this->thread.join();
+	}
+	bool lock() { this->mutex.lock(); return true; }
+	void unlock() { this->mutex.unlock(); }
+	void sleep(long milliseconds) { this_thread::sleep_for(chrono::milliseconds(milliseconds)); }
+	void yield() { this_thread::yield(); }
+protected:
+	virtual void threadedFunction() {}
+	std::mutex mutex;
+private:
+	std::thread thread;
+	atomic<bool> running;
+};
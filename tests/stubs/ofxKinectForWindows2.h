@@ -0,0 +1,13 @@
+#pragma once
+
+#include "ofMain.h"
+
+enum JointType {
+	JointType_SpineBase, JointType_SpineMid, JointType_Neck, JointType_Head,
+	JointType_ShoulderLeft, JointType_ElbowLeft, JointType_WristLeft, JointType_HandLeft,
+	JointType_ShoulderRight, JointType_ElbowRight, JointType_WristRight, JointType_HandRight,
+	JointType_HipLeft, JointType_KneeLeft, JointType_AnkleLeft, JointType_FootLeft,
+	JointType_HipRight, JointType_KneeRight, JointType_AnkleRight, JointType_FootRight,
+	JointType_SpineShoulder, JointType_HandTipLeft, JointType_ThumbLeft, JointType_HandTipRight, JointType_ThumbRight,
+	JointType_Count
+};
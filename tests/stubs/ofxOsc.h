@@ -0,0 +1,103 @@
+#pragma once
+
+#include "ofMain.h"
+#include <random>
+
+// In-process stand-in for ofxOsc: receivers listen on a port of one shared network, senders deliver to
+// that port whatever host they were given (every address reaches the same machine, like aliases of it).
+// Every message arrives from host 127.0.0.1. Messages can be lost on purpose, and deliveries are counted.
+
+class ofxOscMessage {
+public:
+	void setAddress(const string& address) { this->address = address; }
+	const string& getAddress() const { return this->address; }
+
+	void addInt32Arg(int32_t value) { this->arguments.push_back(Argument('i', value)); }
+	void addInt64Arg(int64_t value) { this->arguments.push_back(Argument('h', value)); }
+	void addBlobArg(const ofBuffer& blob) { Argument argument('b', 0); argument.blob = blob; this->arguments.push_back(argument); }
+
+	size_t getNumArgs() const { return this->arguments.size(); }
+	int32_t getArgAsInt(size_t index) const { return (int32_t)this->arguments.at(index).value; }
+	int32_t getArgAsInt32(size_t index) const { return (int32_t)this->arguments.at(index).value; }
+	int64_t getArgAsInt64(size_t index) const { return this->arguments.at(index).value; }
+	ofBuffer getArgAsBlob(size_t index) const { return this->arguments.at(index).blob; }
+
+	void setRemoteEndpoint(const string& host, int port) { this->remoteHost = host; this->remotePort = port; }
+	string getRemoteHost() const { return this->remoteHost; }
+	int getRemotePort() const { return this->remotePort; }
+
+private:
+	struct Argument {
+		char type;
+		int64_t value;
+		ofBuffer blob;
+		Argument(char type, int64_t value) : type(type), value(value) {}
+	};
+	string address;
+	vector<Argument> arguments;
+	string remoteHost;
+	int remotePort = 0;
+};
+
+class ofxOscTestNetwork {
+public:
+	static ofxOscTestNetwork& get() { static ofxOscTestNetwork network; return network; }
+
+	void send(int port, const ofxOscMessage& message) {
+		lock_guard<std::mutex> lock(this->mutex);
+		if (this->lossRate > 0 && this->uniform(this->random) < this->lossRate) return;
+		auto queue = this->queues.find(port);
+		if (queue == this->queues.end()) return;
+		// Counted by destination, address and first argument (the site messages come from)
+		int origin = (message.getNumArgs() > 0) ? message.getArgAsInt(0) : -1;
+		this->deliveries[make_tuple(port, message.getAddress(), origin)]++;
+		queue->second.push_back(message);
+		queue->second.back().setRemoteEndpoint("127.0.0.1", 0);
+	}
+
+	void listen(int port) { lock_guard<std::mutex> lock(this->mutex); this->queues[port]; }
+
+	bool receive(int port, ofxOscMessage& message) {
+		lock_guard<std::mutex> lock(this->mutex);
+		deque<ofxOscMessage>& queue = this->queues[port];
+		if (queue.empty()) return false;
+		message = queue.front();
+		queue.pop_front();
+		return true;
+	}
+
+	bool hasWaiting(int port) { lock_guard<std::mutex> lock(this->mutex); return !this->queues[port].empty(); }
+
+	int getDeliveries(int port, const string& address, int origin) {
+		lock_guard<std::mutex> lock(this->mutex);
+		return this->deliveries[make_tuple(port, address, origin)];
+	}
+
+	void resetDeliveries() { lock_guard<std::mutex> lock(this->mutex); this->deliveries.clear(); }
+	void setLossRate(double lossRate) { lock_guard<std::mutex> lock(this->mutex); this->lossRate = lossRate; }
+
+private:
+	std::mutex mutex;
+	map<int, deque<ofxOscMessage> > queues;
+	map<tuple<int, string, int>, int> deliveries;
+	double lossRate = 0;
+	mt19937 random{ 1 };
+	uniform_real_distribution<double> uniform{ 0, 1 };
+};
+
+class ofxOscSender {
+public:
+	void setup(const string& host, int port) { this->port = port; }
+	void sendMessage(const ofxOscMessage& message, bool wrapInBundle = true) { ofxOscTestNetwork::get().send(this->port, message); }
+private:
+	int port = 0;
+};
+
+class ofxOscReceiver {
+public:
+	void setup(int port) { this->port = port; ofxOscTestNetwork::get().listen(port); }
+	bool hasWaitingMessages() { return ofxOscTestNetwork::get().hasWaiting(this->port); }
+	bool getNextMessage(ofxOscMessage* message) { return ofxOscTestNetwork::get().receive(this->port, *message); }
+private:
+	int port = 0;
+};